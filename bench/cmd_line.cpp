@@ -0,0 +1,65 @@
+//
+// Copyright 2018 Rambler Digital Solutions
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Command line parse time for repeated list arguments, argv sizes 10..1M.
+// Time per argument should stay flat as the number of arguments grows.
+
+#include <raconfig/raconfig.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace option
+{
+
+RACONFIG_OPTION(blackhost, std::vector<std::string>, {},
+    "blackhost", "blacklist.item", "List of dangerous hosts")
+RACONFIG_OPTION(port, std::vector<unsigned short>, {},
+    "port", "server.port", "List of ports")
+RACONFIG_OPTION(verbose, bool, false,
+    "verbose,v", "verbose", "Verbose output")
+
+} // namespace option
+
+using config = raconfig::config<raconfig::default_actions,
+    option::blackhost,
+    option::port,
+    option::verbose>;
+
+int main()
+{
+    std::printf("%10s %12s %12s\n", "args", "total, ms", "per arg, ns");
+    for (size_t n = 10; n <= 1000000; n *= 10) {
+        std::vector<std::string> args;
+        args.reserve(n);
+        for (size_t i = 0; i < n; ++i)
+            args.push_back(i % 2 ? "--port=" + std::to_string(i % 65536)
+                                 : "--blackhost=host" + std::to_string(i) + ".example.com");
+        std::vector<const char*> argv{""};
+        for (auto const& arg: args)
+            argv.push_back(arg.c_str());
+
+        auto const start = std::chrono::steady_clock::now();
+        config::instance().parse_cmd_line(static_cast<int>(argv.size()), argv.data());
+        auto const elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (config::instance().get<option::blackhost>().size() + config::instance().get<option::port>().size() != n)
+            return 1;
+        std::printf("%10zu %12.3f %12.1f\n", n, elapsed * 1e3, elapsed * 1e9 / n);
+        std::fflush(stdout);
+    }
+}
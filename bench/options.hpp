@@ -0,0 +1,61 @@
+//
+// Copyright 2018 Rambler Digital Solutions
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef RACONFIG_BENCH_OPTIONS_HPP
+#define RACONFIG_BENCH_OPTIONS_HPP
+
+// Large generated configuration: 128 options of a few common types.
+
+#include <raconfig/raconfig.hpp>
+
+#include <boost/preprocessor/cat.hpp>
+#include <boost/preprocessor/repetition/enum.hpp>
+#include <boost/preprocessor/repetition/repeat.hpp>
+#include <boost/preprocessor/stringize.hpp>
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+#define BENCH_OPTIONS 128
+
+// types are picked by the compiler, BOOST_PP_MOD took longer to
+// preprocess than the whole unit to compile
+template<int N>
+using bench_type = typename std::tuple_element<N % 4,
+    std::tuple<int, std::string, double, std::vector<unsigned>>>::type;
+
+#define BENCH_TYPE(n) bench_type<n>
+
+#define BENCH_OPTION(z, n, _) \
+    RACONFIG_OPTION_CHECKED(BOOST_PP_CAT(o, n), BENCH_TYPE(n), {}, \
+        [](BENCH_TYPE(n) const&) { return n != 1000; }, \
+        BOOST_PP_STRINGIZE(BOOST_PP_CAT(o, n)), "section.o" BOOST_PP_STRINGIZE(n), "Option")
+
+#define BENCH_TAG(z, n, _) option::BOOST_PP_CAT(o, n)
+
+namespace option
+{
+
+BOOST_PP_REPEAT(BENCH_OPTIONS, BENCH_OPTION, _)
+
+} // namespace option
+
+#define BENCH_CONFIG raconfig::default_actions, BOOST_PP_ENUM(BENCH_OPTIONS, BENCH_TAG, _)
+
+using config = raconfig::config<BENCH_CONFIG>;
+
+#endif
@@ -0,0 +1,189 @@
+//
+// Copyright 2018 Rambler Digital Solutions
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Read scaling of get() with 1..N reader threads while another thread
+// rewrites the config file and reloads it at a fixed rate, so reloads
+// read and hash the file as in production.
+//
+//     raconfig-bench-readers [max threads] [reloads per second] [seconds]
+//
+// Every 16th get() of a reader is timed, latencies include the clock
+// overhead printed first. Rates of the slowest and the fastest reader
+// are measured over each reader's own running time. Build with
+// -DSANITIZE_THREAD=ON to check the same workload with ThreadSanitizer.
+
+#include <raconfig/raconfig.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace option
+{
+
+RACONFIG_OPTION_EASY(host, std::string, "localhost", "Listening host")
+RACONFIG_OPTION_EASY(port, unsigned short, 80, "Listening port")
+RACONFIG_OPTION_EASY(workers, unsigned, 4, "Number of workers")
+RACONFIG_OPTION_EASY(blackhost, std::vector<std::string>, {}, "List of dangerous hosts")
+
+} // namespace option
+
+using config = raconfig::config<raconfig::default_actions,
+    option::host,
+    option::port,
+    option::workers,
+    option::blackhost>;
+
+using clock_type = std::chrono::steady_clock;
+
+static uint32_t elapsed_ns(clock_type::time_point start, clock_type::time_point end)
+{
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+}
+
+static double percentile(std::vector<uint32_t> const& sorted, double q)
+{
+    if (sorted.empty())
+        return 0;
+    return sorted[std::min(sorted.size() - 1, static_cast<size_t>(q * sorted.size()))];
+}
+
+struct reader_stats
+{
+    unsigned long long reads = 0;
+    double seconds = 0;
+    std::vector<uint32_t> latencies;
+};
+
+static void reader(std::atomic<bool> const& stop, reader_stats& stats)
+{
+    size_t const max_samples = 1 << 20;
+    stats.latencies.reserve(max_samples);
+    auto const& cfg = config::instance();
+    unsigned long long sink = 0;
+    auto const begin = clock_type::now();
+    while (!stop.load(std::memory_order_relaxed)) {
+        cfg.quiescent();
+        for (int i = 0; i < 5; ++i) {
+            sink += cfg.get<option::port>();
+            sink += cfg.get<option::workers>();
+            sink += cfg.get<option::host>().size();
+        }
+        auto const start = clock_type::now();
+        sink += cfg.get<option::port>();
+        auto const end = clock_type::now();
+        if (stats.latencies.size() < max_samples)
+            stats.latencies.push_back(elapsed_ns(start, end));
+        stats.reads += 16;
+    }
+    stats.seconds = std::chrono::duration<double>(clock_type::now() - begin).count();
+    if (sink == 0)
+        std::abort();
+}
+
+static char const config_path[] = "raconfig-bench-readers.ini";
+
+static void write_config(unsigned long i)
+{
+    std::ofstream file{config_path, std::ios::trunc};
+    file << "port=" << 8000 + i % 2 << "\n"
+            "workers=" << 1 + i % 16 << "\n"
+            "host=example.com\n"
+            "blackhost=a.example.com\n"
+            "blackhost=b.example.com\n";
+}
+
+// the file is rewritten outside of the timed reload
+static void writer(std::atomic<bool> const& stop, unsigned rate, std::vector<uint32_t>& latencies)
+{
+    auto const interval = std::chrono::nanoseconds{1000000000 / rate};
+    auto next = clock_type::now();
+    for (unsigned long i = 0; !stop.load(std::memory_order_relaxed); ++i) {
+        write_config(i);
+        auto const start = clock_type::now();
+        config::instance().reload();
+        latencies.push_back(elapsed_ns(start, clock_type::now()));
+        next += interval;
+        std::this_thread::sleep_until(next);
+    }
+}
+
+static void run(unsigned threads, unsigned rate, double seconds)
+{
+    std::atomic<bool> stop{false};
+    std::vector<reader_stats> stats(threads);
+    std::vector<uint32_t> reloads;
+    std::vector<std::thread> readers;
+    for (auto& s: stats)
+        readers.emplace_back(reader, std::cref(stop), std::ref(s));
+    std::thread w;
+    if (rate > 0)
+        w = std::thread{writer, std::cref(stop), rate, std::ref(reloads)};
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop.store(true, std::memory_order_relaxed);
+    for (auto& r: readers)
+        r.join();
+    if (w.joinable())
+        w.join();
+
+    unsigned long long total = 0;
+    std::vector<double> rates;
+    std::vector<uint32_t> latencies;
+    for (auto const& s: stats) {
+        total += s.reads;
+        rates.push_back(s.seconds > 0 ? s.reads / s.seconds : 0);
+        latencies.insert(latencies.end(), s.latencies.begin(), s.latencies.end());
+    }
+    auto const minmax = std::minmax_element(rates.begin(), rates.end());
+    std::sort(latencies.begin(), latencies.end());
+    std::sort(reloads.begin(), reloads.end());
+    std::printf("%7u %14.1f %16.1f %16.1f %8.0f %8.0f %8.0f %8zu %10.1f %10.1f\n", threads,
+                total / seconds / 1e6, *minmax.first / 1e6, *minmax.second / 1e6,
+                percentile(latencies, 0.5), percentile(latencies, 0.99), percentile(latencies, 0.999),
+                reloads.size(), percentile(reloads, 0.5) / 1e3, percentile(reloads, 0.99) / 1e3);
+    std::fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned const max_threads = argc > 1 ? std::atoi(argv[1]) : std::max(1u, std::thread::hardware_concurrency());
+    unsigned const rate = argc > 2 ? std::atoi(argv[2]) : 100;
+    double const seconds = argc > 3 ? std::atof(argv[3]) : 1;
+
+    write_config(1);
+    config::instance().parse_file(config_path);
+
+    std::vector<uint32_t> overhead;
+    for (int i = 0; i < 100000; ++i) {
+        auto const start = clock_type::now();
+        overhead.push_back(elapsed_ns(start, clock_type::now()));
+    }
+    std::sort(overhead.begin(), overhead.end());
+    std::printf("clock overhead %.0f ns, %u reloads per second\n", percentile(overhead, 0.5), rate);
+    std::printf("%7s %14s %16s %16s %8s %8s %8s %8s %10s %10s\n", "threads", "total, M/s",
+                "min/thread, M/s", "max/thread, M/s",
+                "p50, ns", "p99, ns", "p999, ns", "reloads", "p50, us", "p99, us");
+    for (unsigned threads = 1; threads <= max_threads; threads = threads < max_threads && threads * 2 > max_threads
+                                                                   ? max_threads : threads * 2)
+        run(threads, rate, seconds);
+    std::remove(config_path);
+}
@@ -0,0 +1,35 @@
+//
+// Copyright 2018 Rambler Digital Solutions
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Large generated configuration of options.hpp. Compare code size of the
+// binary (size -A raconfig-bench-size) to see how much text configuration
+// code adds per option.
+
+#include "options.hpp"
+
+#include <cstdio>
+
+int main(int argc, char *argv[])
+{
+    try {
+        config::instance().parse_cmd_line(argc, argv);
+    } catch (raconfig::config_error const& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    std::printf("o0 = %d, o1 = %s\n", config::instance().get<option::o0>(),
+                config::instance().get<option::o1>().c_str());
+}
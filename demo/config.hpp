@@ -18,17 +18,10 @@
 #define CONFIG_HPP
 
 #include <raconfig/raconfig.hpp>
+#include <raconfig/raconfig_enum.hpp>
 #include <raconfig/raconfig_set.hpp>
 
-enum class color
-{
-    red,
-    green,
-    blue
-};
-
-std::istream& operator >> (std::istream& is, color& c);
-std::ostream& operator << (std::ostream& os, color c);
+RACONFIG_ENUM(color, red, green, blue)
 
 namespace option
 {
@@ -61,10 +54,10 @@ RACONFIG_OPTION_CHECKED(power2,
                         // item = 4
                         // item = 8
     "Power of 2 numbers")
-RACONFIG_OPTION(color, ::color, ::color::red, // require stream >> and << operators
-    "color",
+RACONFIG_OPTION(color, ::color, ::color::red, // --color=GREEN, allowed values
+    "color",                                  // are shown by --help
     "common.color",
-    "RGB color (red|green|blue)")
+    "RGB color")
 
 } // namespace option
 
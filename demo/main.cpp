@@ -18,36 +18,6 @@
 #include <boost/program_options/options_description.hpp>
 #include <iostream>
 
-std::istream& operator >> (std::istream& is, color& c)
-{
-    std::string str;
-    is >> str;
-    std::transform(str.begin(), str.end(), str.begin(), ::tolower);
-    if (str == "red")
-        c = color::red;
-    else if (str == "green")
-        c = color::green;
-    else if (str == "blue")
-        c = color::blue;
-    else
-        throw std::runtime_error{"Unknown color"};
-    return is;
-}
-
-std::ostream& operator << (std::ostream& os, color c)
-{
-    switch (c) {
-    case color::red:
-        return os << "RED";
-    case color::green:
-        return os << "GREEN";
-    case color::blue:
-        return os << "BLUE";
-    default:
-        return os << "?";
-    }
-}
-
 void actions::version(const char* ver)
 {
     std::cout << "***********\n"
@@ -18,9 +18,31 @@
 #define RACONFIG_HPP
 
 #include <boost/program_options/value_semantic.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <tuple>
+#include <unordered_map>
 #include "raconfig_range.hpp"
 
+#if __cplusplus >= 201703L
+#include <charconv>
+#endif
+#if __cplusplus >= 202002L
+#include <coroutine>
+#endif
+
+// file descriptors and the process environment are read by POSIX calls
+#if !defined(RACONFIG_POSIX) && (defined(__unix__) || (defined(__APPLE__) && defined(__MACH__)))
+#define RACONFIG_POSIX
+#endif
+
 namespace raconfig
 {
 
@@ -31,10 +53,19 @@ public:
     explicit config_error(const char* what);
 };
 
-namespace detail
+// Notified by the committing thread right after a new configuration
+// generation is published. Should be cheap and must not block.
+class commit_listener
 {
+public:
+    virtual void committed(unsigned long generation) noexcept = 0;
 
-#if __cplusplus < 201402L
+protected:
+    ~commit_listener() = default;
+};
+
+namespace detail
+{
 
 template<size_t I, class T, class H, class ...Ts>
 struct find_type
@@ -48,6 +79,8 @@ struct find_type<I, T, T, Ts...>
     static constexpr size_t index = I;
 };
 
+#if __cplusplus < 201402L
+
 template<class T, class ...Ts>
 T const& get(std::tuple<Ts...> const& t) noexcept
 {
@@ -70,7 +103,7 @@ T& get(std::tuple<Ts...>& t) noexcept { return std::get<T>(t); }
 
 #endif
 
-template<class T>
+template<class T, class = void>
 struct type_proxy
 {
     static std::string to_string(T const& v)
@@ -82,6 +115,8 @@ struct type_proxy
     {
         return actions.show_config(name, to_string(v));
     }
+
+    static size_t heap_usage(T const&) noexcept { return 0; }
 };
 
 template<class T>
@@ -90,10 +125,45 @@ std::string to_string(T const& v)
     return type_proxy<T>::to_string(v);
 }
 
+// estimated number of heap bytes owned by the value
+template<class T>
+size_t heap_usage(T const& v)
+{
+    return type_proxy<T>::heap_usage(v);
+}
+
+template<class Char, class Traits, class Allocator>
+struct type_proxy<std::basic_string<Char, Traits, Allocator>>
+{
+    using type = std::basic_string<Char, Traits, Allocator>;
+
+    static std::string to_string(type const& v)
+    {
+        return boost::lexical_cast<std::string>(v);
+    }
+
+    static void show_option(default_actions& actions, const char *name, type const& v)
+    {
+        return actions.show_config(name, to_string(v));
+    }
+
+    static size_t heap_usage(type const& v) noexcept
+    {
+        // short strings are stored inline
+        return v.capacity() > type{}.capacity() ? (v.capacity() + 1) * sizeof(Char) : 0;
+    }
+};
+
 template<class T, class Allocator>
 struct type_proxy<std::vector<T, Allocator>>:
     type_proxy_range<std::vector<T, Allocator>>
-{};
+{
+    static size_t heap_usage(std::vector<T, Allocator> const& v)
+    {
+        return v.capacity() * sizeof(T) +
+            type_proxy_range<std::vector<T, Allocator>>::elements_heap_usage(v);
+    }
+};
 
 template<class T>
 class option_value: public option_value_backend<T>
@@ -108,15 +178,432 @@ public:
     {}
 
     T const& operator ()(get_user_type) const noexcept { return **this; }
+    T const& operator ()(get_unchecked) const noexcept { return **this; }
+    size_t operator ()(get_heap_usage) const { return detail::heap_usage(**this); }
     void operator ()(transform_backend) { /* no transformation */ }
 };
 
+struct check_value{};
+
+struct lazy_option{};
+
+// Option value transformed and checked on first access instead of at
+// parse time. Initialization is thread safe and happens exactly once per
+// parsed value, a failed check is rethrown on every access.
+template<class Option, class T>
+class lazy_option_value: public option_value<T>, public lazy_option
+{
+public:
+    using option_value<T>::operator ();
+
+    lazy_option_value(T const& value)
+        : option_value<T>{value}
+    {}
+
+    lazy_option_value(T&& value)
+        : option_value<T>{std::move(value)}
+    {}
+
+    T const& operator ()(get_user_type) const
+    {
+        if (!ready_.load(std::memory_order_acquire))
+            materialize();
+        return (*this)(get_unchecked{});
+    }
+
+    void operator ()(transform_backend) { /* deferred until first access */ }
+
+private:
+    void materialize() const
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        if (ready_.load(std::memory_order_relaxed))
+            return;
+        auto& self = const_cast<lazy_option_value&>(*this);
+        self.option_value<T>::operator ()(transform_backend{});
+        static_cast<Option const&>(*this)(check_value{});
+        ready_.store(true, std::memory_order_release);
+    }
+
+    mutable std::mutex mutex_;
+    mutable std::atomic<bool> ready_{false};
+};
+
+template<class Option>
+typename std::enable_if<!std::is_base_of<lazy_option, Option>::value>::type
+transform_option(Option& option, bool)
+{
+    option(transform_backend{});
+}
+
+template<class Option>
+typename std::enable_if<std::is_base_of<lazy_option, Option>::value>::type
+transform_option(Option& option, bool eager)
+{
+    if (eager)
+        option(get_user_type{});
+}
+
+template<class Option>
+typename std::enable_if<!std::is_base_of<lazy_option, Option>::value>::type
+check_option(Option const& option)
+{
+    option(check_value{});
+}
+
+template<class Option>
+typename std::enable_if<std::is_base_of<lazy_option, Option>::value>::type
+check_option(Option const&)
+{
+    // checked along with transformation
+}
+
+// Option values which depend on something besides their input (or are
+// changed in place) are not shared between snapshots
+struct unshareable_option{};
+
+template<class Option>
+using is_shareable = std::integral_constant<bool,
+    !std::is_base_of<unshareable_option, Option>::value>;
+
+// Option values which read external input (e.g. a file by path) are
+// shared and skip reloads only while option(input_unchanged{}) is true,
+// a hash of the configuration inputs can't cover the external one
+struct external_option{};
+struct input_unchanged{};
+
+template<class Option>
+using is_external = std::is_base_of<external_option, Option>;
+
+// Options copied to every NUMA node, lazy options are not copyable
+template<class Option>
+using is_replicable = std::integral_constant<bool,
+    is_shareable<Option>::value && std::is_copy_constructible<Option>::value>;
+
+// hash of the last committed configuration inputs
+struct input_hash
+{
+    bool valid = false;
+    uint64_t args = 0;
+    uint64_t value = 0;
+    std::string config;
+};
+
+// input digest of options changed at runtime, parsed inputs never have it
+constexpr uint64_t runtime_input = 1;
+
+// where to read the configuration file from instead of --config path
+struct config_source
+{
+    const char *path;
+    const char *data;
+    size_t size;
+    int fd;
+};
+
+// config file section parsed on its own, path is empty for a buffer
+struct section_source
+{
+    std::string name;
+    std::string path;
+};
+
+// Environment variables of options named by prefix_NAME, NAME is the
+// config file name in upper case with '.' and '-' replaced by '_'
+struct env_source
+{
+    std::string prefix;
+    // names without prefix to config file names
+    std::unordered_map<std::string, const char*> names;
+};
+
+#ifdef RACONFIG_TRACE_ACCESS
+
+// RACONFIG_TRACE_ACCESS=N counts one of every N accesses of a thread
+#if RACONFIG_TRACE_ACCESS + 0 > 1
+#define RACONFIG_DETAIL_ACCESS_PERIOD (RACONFIG_TRACE_ACCESS)
+#else
+#define RACONFIG_DETAIL_ACCESS_PERIOD 1
+#endif
+
+// Per-option access counters sharded by thread. Threads are spread over
+// the shards round robin and every shard occupies its own cache lines,
+// so concurrent readers rarely contend for a counter.
+class access_counters
+{
+public:
+    explicit access_counters(size_t size)
+        : stride_{(size + 7) / 8 * 8 + 8}
+        , counters_{new std::atomic<uint64_t>[shards * stride_]}
+    {
+        for (size_t i = 0; i < shards * stride_; ++i)
+            counters_[i].store(0, std::memory_order_relaxed);
+    }
+
+    void hit(size_t i) const noexcept
+    {
+#if RACONFIG_DETAIL_ACCESS_PERIOD > 1
+        static thread_local unsigned countdown = 0;
+        if (countdown-- != 0)
+            return;
+        countdown = RACONFIG_DETAIL_ACCESS_PERIOD - 1;
+#endif
+        static thread_local size_t const shard = next_shard();
+        counters_[shard * stride_ + i].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // estimated number of accesses of the option
+    uint64_t count(size_t i) const noexcept
+    {
+        uint64_t n = 0;
+        for (size_t shard = 0; shard < shards; ++shard)
+            n += counters_[shard * stride_ + i].load(std::memory_order_relaxed);
+        return n * RACONFIG_DETAIL_ACCESS_PERIOD;
+    }
+
+private:
+    static constexpr size_t shards = 16;
+
+    static size_t next_shard() noexcept
+    {
+        static std::atomic<size_t> next{0};
+        return next.fetch_add(1, std::memory_order_relaxed) % shards;
+    }
+
+    size_t const stride_;
+    std::unique_ptr<std::atomic<uint64_t>[]> const counters_;
+};
+
+#endif
+
+template<class ...Ts>
+struct snapshot
+{
+    // option of type Ts[i] by index i
+    std::array<std::shared_ptr<void const>, sizeof...(Ts)> options;
+    // digest of every option's input, 0 for default values
+    std::array<uint64_t, sizeof...(Ts)> inputs{};
+    bool parsed = false;
+    // values of config::derived by their ids
+    std::vector<std::shared_ptr<void const>> derived;
+};
+
+template<class T, class ...Ts>
+T const& get(snapshot<Ts...> const& s) noexcept
+{
+    return *static_cast<T const*>(std::get<find_type<0, T, Ts...>::index>(s.options).get());
+}
+
+// what config::get<Option>() returns
+template<class Option>
+using user_ref = decltype(std::declval<Option const&>()(get_user_type{}));
+
 template<class T>
 T deduce_value_backend_type(option_value_backend<T>&&) noexcept;
 
 template<class Option>
 using value_backend_type = decltype(deduce_value_backend_type(std::declval<Option>()));
 
+// Numbers converted without iostreams, character types are excluded
+// since lexical_cast treats them as characters, not as numbers
+template<class T>
+using is_fast_number = std::integral_constant<bool,
+    std::is_arithmetic<T>::value && !std::is_same<T, bool>::value &&
+    !std::is_same<T, char>::value && !std::is_same<T, signed char>::value &&
+    !std::is_same<T, unsigned char>::value && !std::is_same<T, wchar_t>::value &&
+    !std::is_same<T, char16_t>::value && !std::is_same<T, char32_t>::value>;
+
+// Scanners accept only plain decimal numbers in range, anything else
+// (signs of unsigned numbers, overflow, inf, hex...) is left to
+// lexical_cast which either converts it or reports the error as before.
+template<class T>
+typename std::enable_if<std::is_integral<T>::value, bool>::type
+scan_number(std::string const& s, T& value) noexcept
+{
+    using U = typename std::make_unsigned<T>::type;
+    const char *p = s.c_str();
+    bool const negative = std::is_signed<T>::value && *p == '-';
+    if (negative)
+        ++p;
+    U const limit = negative ? U(std::numeric_limits<T>::max()) + 1 : U(std::numeric_limits<T>::max());
+    U x = 0;
+    const char *const first = p;
+    for (; *p >= '0' && *p <= '9'; ++p) {
+        unsigned const digit = *p - '0';
+        if (x > (limit - digit) / 10)
+            return false;
+        x = U(x * 10 + digit);
+    }
+    if (p == first || *p != '\0' || p != s.c_str() + s.size())
+        return false;
+    value = negative ? T(U(0) - x) : T(x);
+    return true;
+}
+
+template<class T>
+typename std::enable_if<std::is_floating_point<T>::value, bool>::type
+scan_number(std::string const& s, T& value) noexcept
+{
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    const char *first = s.data();
+    const char *const last = first + s.size();
+    const char *p = first;
+    if (p != last && *p == '-')
+        ++p;
+    // digits[.digits][e[sign]digits], no inf, nan or hex
+    const char *const mantissa = p;
+    while (p != last && *p >= '0' && *p <= '9')
+        ++p;
+    if (p != last && *p == '.')
+        for (++p; p != last && *p >= '0' && *p <= '9'; ++p);
+    if (p - mantissa == 0 || (p - mantissa == 1 && *mantissa == '.'))
+        return false;
+    if (p != last && (*p == 'e' || *p == 'E')) {
+        ++p;
+        if (p != last && (*p == '-' || *p == '+'))
+            ++p;
+        const char *const exponent = p;
+        while (p != last && *p >= '0' && *p <= '9')
+            ++p;
+        if (p == exponent)
+            return false;
+    }
+    if (p != last)
+        return false;
+    auto const res = std::from_chars(first, last, value);
+    return res.ec == std::errc{} && res.ptr == last;
+#else
+    (void)s;
+    (void)value;
+    return false;
+#endif
+}
+
+template<class T>
+T parse_number(std::string const& s)
+{
+    T value;
+    if (scan_number(s, value))
+        return value;
+    try {
+        return boost::lexical_cast<T>(s);
+    } catch (boost::bad_lexical_cast const&) {
+        boost::throw_exception(boost::program_options::invalid_option_value(s));
+    }
+}
+
+// Single numeric value converted without iostreams, errors are the same
+// as for boost validate()
+template<class T>
+class number_value: public boost::program_options::typed_value<T>
+{
+    using base_type = boost::program_options::typed_value<T>;
+
+public:
+    number_value()
+        : base_type{nullptr}
+    {}
+
+    void xparse(boost::any& value_store, std::vector<std::string> const& tokens) const override
+    {
+        if (tokens.empty())
+            return base_type::xparse(value_store, tokens);
+        boost::program_options::validators::check_first_occurrence(value_store);
+        value_store = parse_number<T>(boost::program_options::validators::get_single_string(tokens));
+    }
+};
+
+// Command line parser passes all tokens of repeated list options at once
+struct list_semantic{};
+
+// Converts list items straight from tokens, other types go through boost
+// validate(). Specialized for named enums in raconfig_enum.hpp.
+template<class T, class = void>
+struct list_item: std::false_type {};
+
+template<>
+struct list_item<std::string>: std::true_type
+{
+    static std::string const& parse(std::string const& token) noexcept
+    {
+        return token;
+    }
+};
+
+template<class T>
+struct list_item<T, typename std::enable_if<is_fast_number<T>::value>::type>: std::true_type
+{
+    static T parse(std::string const& token)
+    {
+        return parse_number<T>(token);
+    }
+};
+
+// Appends tokens straight into the vector. Items with list_item are
+// converted in place, other types go through boost validate() as usual.
+template<class T, class Allocator>
+class list_value
+    : public boost::program_options::typed_value<std::vector<T, Allocator>>
+    , public list_semantic
+{
+    using base_type = boost::program_options::typed_value<std::vector<T, Allocator>>;
+
+public:
+    list_value()
+        : base_type{nullptr}
+    {}
+
+    void xparse(boost::any& value_store, std::vector<std::string> const& tokens) const override
+    {
+        if (tokens.empty())
+            return base_type::xparse(value_store, tokens);
+        append_tokens(value_store, tokens, list_item<T>{});
+    }
+
+private:
+    void append_tokens(boost::any& value_store, std::vector<std::string> const& tokens, std::false_type) const
+    {
+        base_type::xparse(value_store, tokens);
+    }
+
+    void append_tokens(boost::any& value_store, std::vector<std::string> const& tokens, std::true_type) const
+    {
+        if (value_store.empty())
+            value_store = std::vector<T, Allocator>{};
+        auto& v = boost::any_cast<std::vector<T, Allocator>&>(value_store);
+        v.reserve(v.size() + tokens.size());
+        for (auto const& token: tokens)
+            v.push_back(list_item<T>::parse(token));
+    }
+};
+
+template<class T, class = void>
+struct backend_semantic
+{
+    static boost::program_options::value_semantic* make()
+    {
+        return boost::program_options::value<T>();
+    }
+};
+
+template<class T>
+struct backend_semantic<T, typename std::enable_if<is_fast_number<T>::value>::type>
+{
+    static boost::program_options::value_semantic* make()
+    {
+        return new number_value<T>;
+    }
+};
+
+template<class T, class Allocator>
+struct backend_semantic<std::vector<T, Allocator>, void>
+{
+    static boost::program_options::value_semantic* make()
+    {
+        return new list_value<T, Allocator>;
+    }
+};
+
 class options_parser
 {
 public:
@@ -128,12 +615,26 @@ public:
     options_parser& operator = (options_parser&&) = delete;
 
     void add(const char *name, const char *description, boost::program_options::value_semantic const *s = nullptr);
+    // options are parsed but not converted until store() call
     void parse_command_line(int argc, const char* const argv[]);
     void parse_config_file(const char *path);
-    void notify();
+    void parse_config_buffer(const char *data, size_t size);
+#ifdef RACONFIG_POSIX
+    void parse_config_fd(int fd);
+#endif
+    // config file options from environment variables
+    void parse_environment(env_source const& env);
+    // exclude an option from conversion
+    void skip(const char *name);
+    void store();
 
+    // queries about parsed options, short name suffix is ignored
     bool has(const char *name) const;
     bool get(const char *name, std::string& value) const;
+    // hash of option's input tokens or 0 if the option is not given
+    uint64_t digest(const char *name) const;
+    // converted value of an option or nullptr
+    boost::any* value(const char *name);
 
     operator boost::program_options::options_description const& () const noexcept;
 
@@ -148,7 +649,6 @@ struct name{};
 struct cmd_name{};
 struct cfg_name{};
 struct description{};
-struct check_value{};
 
 template<class Option>
 void show_option(default_actions& actions, Option const& option)
@@ -159,75 +659,585 @@ void show_option(default_actions& actions, Option const& option)
             >::type>::show_option(actions, option(name{}), v);
 }
 
-template<class T>
-constexpr bool skip_option_check(T&&) { return true; }
-
-void throw_option_check_failed(const char *name, const char *value);
-
-} // namespace detail
-
-#if __cplusplus < 201703L
-#define RACONFIG_FOLD(expr) { int _[] = {((expr), 0)...}; (void)_; }
-#else
-#define RACONFIG_FOLD(expr) (..., (expr))
-#endif
+template<class Option>
+using user_type = typename std::decay<
+    decltype(std::declval<Option const&>()(get_unchecked{}))>::type;
 
-#if __cplusplus < 201402L
-namespace detail
+template<class Option>
+size_t memory_usage(Option const& option)
 {
-template<class T>
-T deduce_value_type(option_value<T>&&) noexcept;
+    return sizeof(Option) + option(get_heap_usage{});
 }
-#define RACONFIG_VALUE_TYPE(T) decltype(detail::deduce_value_type(std::declval<T>()))
-#else
-#define RACONFIG_VALUE_TYPE(T) auto
-#endif
 
-template<class Actions, class ...Ts>
-class config final
+struct option_names
 {
-    static_assert(std::is_base_of<default_actions, Actions>::value,
-                  "Actions should derive from default_actions");
+    const char *name;
+    const char *cmd_name;
+    const char *cfg_name;
+    const char *description;
+};
 
-    using this_type = config<Actions, Ts...>;
+// Type-erased operations on an option. Options of a config are parsed,
+// checked and shown by shared non-template code through a constant table
+// of these, so every option adds only a few small functions.
+struct option_ops
+{
+    using copy_function = std::shared_ptr<void const> (*)(void const *option);
+    using unchanged_function = bool (*)(void const *option);
 
-public:
-    static this_type& instance()
+    void (*names)(void const *option, option_names& names);
+    boost::program_options::value_semantic* (*semantic)();
+    // new option from a parsed value (default if nullptr), transformed
+    // and checked
+    std::shared_ptr<void const> (*make)(boost::any *value, bool eager);
+    // nullptr unless the option is external, false if the external input
+    // has changed since the option was made
+    unchanged_function unchanged;
+    // nullptr unless the option is lazy
+    void (*prepare_shared)(void const *option, bool eager);
+    // nullptr if the option is not replicable
+    copy_function copy;
+    void (*show)(default_actions& actions, void const *option);
+    std::string (*to_string)(void const *option);
+    size_t (*memory_usage)(void const *option);
+    bool shareable;
+};
+
+template<class Option>
+struct option_thunks
+{
+    static Option const& cast(void const *option) noexcept
     {
-        static this_type inst;
-        return inst;
+        return *static_cast<Option const*>(option);
     }
 
-    template<class T>
-    RACONFIG_VALUE_TYPE(T) const& get() const noexcept
+    static void names(void const *option, option_names& names)
     {
-        return detail::get<T>(options_)(detail::get_user_type{});
+        names.name = cast(option)(name{});
+        names.cmd_name = cast(option)(cmd_name{});
+        names.cfg_name = cast(option)(cfg_name{});
+        names.description = cast(option)(description{});
     }
 
-    void parse_cmd_line(int argc, const char* const argv[])
+    static std::shared_ptr<void const> make(boost::any *value, bool eager)
     {
-        try {
-            parse_cmd_line_impl(argc, argv);
-        } catch (config_error const& e) {
-            throw;
-        } catch (std::exception const& e) {
-            std::throw_with_nested(config_error{e.what()});
-        } catch (...) {
-            std::throw_with_nested(config_error{"unknown exception"});
-        }
-        for (auto cb: callbacks_)
-            cb();
+        auto option = std::make_shared<Option>();
+        if (value)
+            **option = std::move(boost::any_cast<value_backend_type<Option>&>(*value));
+        transform_option(*option, eager);
+        check_option(*option);
+        return option;
     }
 
-    void parse_file(const char *path)
+    static bool unchanged(void const *option)
     {
-        const char* args[] = {"", "--config", path};
-        parse_cmd_line(3, args);
+        return cast(option)(input_unchanged{});
     }
 
-    void add_callback(void (*cb)())
+    // shared lazy option is materialized if options became eager
+    static void prepare_shared(void const *option, bool eager)
     {
-        callbacks_.push_back(cb);
+        if (eager)
+            cast(option)(get_user_type{});
+    }
+
+    static std::shared_ptr<void const> copy(void const *option)
+    {
+        return std::make_shared<Option>(cast(option));
+    }
+
+    static void show(default_actions& actions, void const *option)
+    {
+        show_option(actions, cast(option));
+    }
+
+    static std::string to_string(void const *option)
+    {
+        return detail::to_string(cast(option)(get_user_type{}));
+    }
+
+    static size_t memory_usage(void const *option)
+    {
+        return detail::memory_usage(cast(option));
+    }
+};
+
+template<class Option>
+constexpr option_ops::copy_function copy_function(std::true_type) noexcept
+{
+    return &option_thunks<Option>::copy;
+}
+
+template<class Option>
+constexpr option_ops::copy_function copy_function(std::false_type) noexcept
+{
+    return nullptr;
+}
+
+template<class Option>
+constexpr option_ops::unchanged_function unchanged_function(std::true_type) noexcept
+{
+    return &option_thunks<Option>::unchanged;
+}
+
+template<class Option>
+constexpr option_ops::unchanged_function unchanged_function(std::false_type) noexcept
+{
+    return nullptr;
+}
+
+template<class Option>
+constexpr option_ops make_option_ops() noexcept
+{
+    return option_ops{
+        &option_thunks<Option>::names,
+        &backend_semantic<value_backend_type<Option>>::make,
+        &option_thunks<Option>::make,
+        unchanged_function<Option>(is_external<Option>{}),
+        std::is_base_of<lazy_option, Option>::value ? &option_thunks<Option>::prepare_shared : nullptr,
+        copy_function<Option>(is_replicable<Option>{}),
+        &option_thunks<Option>::show,
+        &option_thunks<Option>::to_string,
+        &option_thunks<Option>::memory_usage,
+        is_shareable<Option>::value
+    };
+}
+
+// Non-template view of the snapshots a parse goes from and to
+struct parse_context
+{
+    option_ops const *ops;
+    size_t size;
+    std::shared_ptr<void const> const *prev;
+    uint64_t const *prev_inputs;
+    bool prev_parsed;
+    std::shared_ptr<void const> *next;
+    uint64_t *next_inputs;
+    bool eager;
+    // parse options of this section only, or
+    const char *section;
+    // parse all options but the ones of these sections
+    std::vector<section_source> const *detached;
+    // environment variables overriding the config file, if any
+    env_source const *env;
+};
+
+struct parse_result
+{
+    bool show_config;
+    bool show_memory;
+};
+
+// Parse the command line and the configuration file (or source) into the
+// next options, options with unchanged input are shared with the previous
+// ones and are neither converted nor checked again. version is nullptr
+// if there is no --version option. hash is set unless source is given.
+// Predefined options are ignored if a section is parsed.
+parse_result parse_options(parse_context const& c, int argc, const char* const argv[],
+                           config_source const *source, const char *version,
+                           default_actions& actions, input_hash& hash);
+
+env_source make_env_source(const char *prefix, option_ops const *ops,
+                           std::shared_ptr<void const> const *options, size_t size);
+// hash of environment variables of options in environ order
+uint64_t hash_environment(env_source const& env, uint64_t seed);
+
+// true if an option of the section differs between the snapshots
+bool section_changed(option_ops const *ops, std::shared_ptr<void const> const *prev,
+                     std::shared_ptr<void const> const *next, size_t size, const char *section);
+
+// false if an external option's input has changed since it was made
+bool external_unchanged(option_ops const *ops, std::shared_ptr<void const> const *options, size_t size);
+
+// parse command line overrides of base options, an override replaces
+// an earlier one of the same option
+void parse_overrides(option_ops const *ops, std::shared_ptr<void const> const *base, size_t size,
+                     int argc, const char* const argv[],
+                     std::vector<std::pair<size_t, std::shared_ptr<void const>>>& overrides);
+
+// Replace options by (name, value) pairs, names are tag, command line or
+// config file ones. Updated options get runtime_input digest.
+void parse_updates(option_ops const *ops, std::shared_ptr<void const> *options, uint64_t *inputs, size_t size,
+                   std::vector<std::pair<std::string, std::string>> const& values);
+
+// false if there is no option with the tag, command line or config file name
+bool find_value(option_ops const *ops, std::shared_ptr<void const> const *options, size_t size,
+                std::string const& name, std::string& value);
+
+std::vector<std::pair<const char*, std::string>> option_values(option_ops const *ops,
+                                                               std::shared_ptr<void const> const *options,
+                                                               size_t size);
+
+void show_config(default_actions& actions, option_ops const *ops,
+                 std::shared_ptr<void const> const *options, size_t size);
+void show_memory(default_actions& actions, option_ops const *ops,
+                 std::shared_ptr<void const> const *options, size_t size);
+std::vector<std::pair<const char*, size_t>> memory_usage(option_ops const *ops,
+                                                         std::shared_ptr<void const> const *options,
+                                                         size_t size);
+
+template<class T>
+constexpr bool skip_option_check(T&&) { return true; }
+
+// Values which may be invalid after transformation (e.g. a pattern which
+// can't be compiled) fail the option check
+template<class T>
+struct value_validity
+{
+    static constexpr bool valid(T const&) noexcept { return true; }
+};
+
+void throw_option_check_failed(const char *name, const char *value);
+void throw_system_error(const char *what);
+uint64_t hash_bytes(const void *data, size_t size, uint64_t seed = 0) noexcept;
+uint64_t hash_args(int argc, const char* const argv[]) noexcept;
+
+// NUMA topology from sysfs, a single node if it is unknown
+size_t numa_nodes() noexcept;
+// node of the CPU the calling thread runs on
+size_t numa_node() noexcept;
+// call f(node) for every node in a thread bound to the node's CPUs,
+// nodes whose thread can't be started or throws are skipped
+void run_on_numa_nodes(std::function<void(size_t)> const& f) noexcept;
+// false if the file can't be read
+bool hash_file(const char *path, uint64_t& hash) noexcept;
+
+// call f reporting any failure as config_error
+template<class F>
+void translate_exceptions(F&& f)
+{
+    try {
+        f();
+    } catch (config_error const& e) {
+        throw;
+    } catch (std::exception const& e) {
+        std::throw_with_nested(config_error{e.what()});
+    } catch (...) {
+        std::throw_with_nested(config_error{"unknown exception"});
+    }
+}
+
+} // namespace detail
+
+#if __cplusplus < 201703L
+#define RACONFIG_FOLD(expr) { int _[] = {0, ((expr), 0)...}; (void)_; }
+#else
+#define RACONFIG_FOLD(expr) (..., (expr))
+#endif
+
+#if __cplusplus < 201402L
+namespace detail
+{
+template<class T>
+T deduce_value_type(option_value<T>&&) noexcept;
+}
+#define RACONFIG_VALUE_TYPE(T) decltype(detail::deduce_value_type(std::declval<T>()))
+#else
+#define RACONFIG_VALUE_TYPE(T) auto
+#endif
+
+template<class Actions, class ...Ts>
+class config final
+{
+    static_assert(std::is_base_of<default_actions, Actions>::value,
+                  "Actions should derive from default_actions");
+
+    using this_type = config<Actions, Ts...>;
+
+public:
+    static this_type& instance()
+    {
+        static this_type inst;
+        return inst;
+    }
+
+    // may throw config_error only for lazy options
+    template<class T>
+    RACONFIG_VALUE_TYPE(T) const& get() const
+        noexcept(noexcept(std::declval<T const&>()(detail::get_user_type{})))
+    {
+#ifdef RACONFIG_TRACE_ACCESS
+        accesses_.hit(index<T>::index);
+#endif
+        return detail::get<T>(snapshot())(detail::get_user_type{});
+    }
+
+    // Several options of the same snapshot, so a reload can't tear them
+    // apart, for the price of one get():
+    //     auto const opts = cfg.get<option::host, option::port>();
+    //     connect(std::get<0>(opts), std::get<1>(opts));
+    template<class T, class U, class ...Us>
+    std::tuple<detail::user_ref<T>, detail::user_ref<U>, detail::user_ref<Us>...> get() const
+    {
+#ifdef RACONFIG_TRACE_ACCESS
+        accesses_.hit(index<T>::index);
+        accesses_.hit(index<U>::index);
+        RACONFIG_FOLD(accesses_.hit(index<Us>::index));
+#endif
+        auto const& s = snapshot();
+        return std::tuple<detail::user_ref<T>, detail::user_ref<U>, detail::user_ref<Us>...>{
+            detail::get<T>(s)(detail::get_user_type{}), detail::get<U>(s)(detail::get_user_type{}),
+            detail::get<Us>(s)(detail::get_user_type{})...};
+    }
+
+    void parse_cmd_line(int argc, const char* const argv[])
+    {
+        std::lock_guard<std::mutex> lock{reload_mutex_};
+        parse_cmd_line_locked(argc, argv);
+    }
+
+    void parse_file(const char *path)
+    {
+        const char* args[] = {"", "--config", path};
+        parse_cmd_line(3, args);
+    }
+
+    // Parse configuration file contents from memory or from a file
+    // descriptor (read till EOF, POSIX only) instead of --config path.
+    // Command line options override ones from the buffer.
+    void parse_buffer(const char *data, size_t size, int argc = 0, const char* const argv[] = nullptr)
+    {
+        detail::config_source const source{nullptr, data, size, -1};
+        std::lock_guard<std::mutex> lock{reload_mutex_};
+        parse_cmd_line_locked(argc, argv, &source);
+    }
+
+#ifdef RACONFIG_POSIX
+    void parse_fd(int fd, int argc = 0, const char* const argv[] = nullptr)
+    {
+        detail::config_source const source{nullptr, nullptr, 0, fd};
+        std::lock_guard<std::mutex> lock{reload_mutex_};
+        parse_cmd_line_locked(argc, argv, &source);
+    }
+#endif
+
+    // Parse options of a config file section, i.e. options whose config
+    // file names start with "section.", from a separate file. The rest of
+    // options are kept as is, command line values of the section's options
+    // take precedence as usual. The section becomes detached: full parses
+    // keep its options and reload_section() re-reads the file. Only
+    // callbacks added for the section are called.
+    void parse_section(std::string const& section, const char *path)
+    {
+        detail::config_source const source{path, nullptr, 0, -1};
+        std::lock_guard<std::mutex> lock{reload_mutex_};
+        parse_section_locked(section, source);
+    }
+
+    void parse_section_buffer(std::string const& section, const char *data, size_t size)
+    {
+        detail::config_source const source{nullptr, data, size, -1};
+        std::lock_guard<std::mutex> lock{reload_mutex_};
+        parse_section_locked(section, source);
+    }
+
+    // re-read the file of a section parsed by parse_section()
+    void reload_section(std::string const& section)
+    {
+        std::lock_guard<std::mutex> lock{reload_mutex_};
+        auto const it = find_section(section);
+        if (it == sections_.end() || it->path.empty())
+            throw config_error{"section '" + section + "' can't be reloaded"};
+        std::string const path = it->path;
+        parse_section_locked(section, detail::config_source{path.c_str(), nullptr, 0, -1});
+    }
+
+    // Re-run the last successfully parsed command line (and so the last
+    // config file) through the whole parsing and validation pipeline,
+    // configuration parsed from a buffer or a descriptor can't be reloaded.
+    // Returns false if the config file content is the same as at the last
+    // commit, nothing is parsed and callbacks are not invoked then.
+    bool reload()
+    {
+        std::lock_guard<std::mutex> lock{reload_mutex_};
+        if (!reloadable_)
+            throw config_error{"configuration source can't be reloaded"};
+        if (hash_.valid) {
+            uint64_t hash = hash_.args;
+            if (env_)
+                hash = detail::hash_environment(*env_, hash);
+            if ((hash_.config.empty() || detail::hash_file(hash_.config.c_str(), hash)) &&
+                hash == hash_.value &&
+                detail::external_unchanged(ops(), load()->options.data(), sizeof...(Ts)))
+                return false;
+        }
+        std::vector<std::string> const args = args_;
+        std::vector<const char*> argv;
+        for (auto const& arg: args)
+            argv.push_back(arg.c_str());
+        if (argv.empty())
+            argv.push_back("");
+        parse_cmd_line_locked(static_cast<int>(argv.size()), argv.data());
+        return true;
+    }
+
+    // Change a tunable option of the current snapshot in place. The value
+    // is checked as usual, neither new generation nor callbacks are made.
+    template<class T, class V>
+    void set(V const& value)
+    {
+        detail::user_type<T> const user_value(value);
+        std::lock_guard<std::mutex> lock{reload_mutex_};
+        auto const options = load();
+        auto const& option = detail::get<T>(*options);
+        option(detail::check_value{}, user_value);
+        option(detail::set_value{}, user_value);
+        // the next reload overrides the value
+        hash_.valid = false;
+    }
+
+    // Replace options of the current snapshot by (name, value) pairs, names
+    // are tag, command line or config file ones and repeated names of list
+    // options append items. Values are converted and checked as usual, the
+    // whole batch is published as one generation with one round of
+    // callbacks, section callbacks are invoked for sections of the updated
+    // options. The next reload overrides the values. Returns the new
+    // generation.
+    unsigned long update(std::vector<std::pair<std::string, std::string>> const& values)
+    {
+        std::lock_guard<std::mutex> lock{reload_mutex_};
+        auto const prev = load();
+        auto next = std::make_shared<snapshot_type>(*prev);
+        detail::translate_exceptions([&]() {
+            detail::parse_updates(ops(), next->options.data(), next->inputs.data(), sizeof...(Ts), values);
+            derive(*prev, *next);
+        });
+        publish(next);
+        hash_.valid = false;
+        for (auto cb: callbacks_)
+            cb();
+        // detached sections are updated too, but notified by their own parses
+        for (auto const& cb: section_callbacks_)
+            if (find_section(cb.first) == sections_.end() &&
+                detail::section_changed(ops(), prev->options.data(), next->options.data(),
+                                        sizeof...(Ts), cb.first.c_str()))
+                cb.second();
+        return generation();
+    }
+
+    // current value of an option by its tag, command line or config file
+    // name converted to string, false if there is no such option
+    bool value(std::string const& name, std::string& value) const
+    {
+        auto const options = load();
+        return detail::find_value(ops(), options->options.data(), sizeof...(Ts), name, value);
+    }
+
+    // current values of all options by their tags converted to strings
+    std::vector<std::pair<const char*, std::string>> values() const
+    {
+        auto const options = load();
+        return detail::option_values(ops(), options->options.data(), sizeof...(Ts));
+    }
+
+    // Declare that the calling thread holds no references returned by
+    // get() (or derived::get()) so far. The first call opts the thread in:
+    // from then on its references stay valid until it calls quiescent()
+    // after a reload, snapshots retired by a commit are freed by a later
+    // commit once every opted in thread has called it (or has exited)
+    // since. References of other threads stay valid until their next
+    // get() after a reload. Cheap enough for the top of an event loop
+    // iteration or a request.
+    void quiescent() const
+    {
+        auto& r = local_reader();
+        if (!r.registered)
+            add_reader(r);
+        r.quiescent.store(generation_.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    // number of the current configuration, incremented on every commit
+    unsigned long generation() const noexcept
+    {
+        return generation_.load(std::memory_order_acquire);
+    }
+
+    // estimated memory used by each option of the current snapshot
+    std::vector<std::pair<const char*, size_t>> memory_usage() const
+    {
+        auto const options = load();
+        return detail::memory_usage(ops(), options->options.data(), sizeof...(Ts));
+    }
+
+    // Number of get() calls of each option since start, empty unless
+    // built with RACONFIG_TRACE_ACCESS. Counts of sampled accesses are
+    // scaled by the sampling period.
+    std::vector<std::pair<const char*, unsigned long long>> access_counts() const
+    {
+        std::vector<std::pair<const char*, unsigned long long>> res;
+#ifdef RACONFIG_TRACE_ACCESS
+        auto const options = load();
+        detail::option_names names;
+        for (size_t i = 0; i < sizeof...(Ts); ++i) {
+            ops()[i].names(options->options[i].get(), names);
+            res.emplace_back(names.name, accesses_.count(i));
+        }
+#endif
+        return res;
+    }
+
+    // Copy every committed snapshot to each NUMA node, readers use the
+    // replica of the node they run on. Takes effect on the next parse.
+    void set_numa_replicas(bool enable)
+    {
+        std::lock_guard<std::mutex> lock{reload_mutex_};
+        numa_replicas_ = enable;
+        hash_.valid = false;
+    }
+
+    // Read options from environment variables named prefix_NAME, where
+    // NAME is the config file name in upper case with '.' and '-' replaced
+    // by '_', e.g. MYAPP_SERVER_PORT for server.port with "MYAPP" prefix.
+    // The command line overrides the environment, the environment
+    // overrides the config file. A list option takes one item from its
+    // variable. Takes effect on the next parse, nullptr disables. Throws
+    // config_error if two options have the same variable name.
+    void set_env_prefix(const char *prefix)
+    {
+        std::unique_ptr<detail::env_source> env;
+        if (prefix) {
+            auto const options = load();
+            env.reset(new detail::env_source{detail::make_env_source(prefix, ops(), options->options.data(),
+                                                                     sizeof...(Ts))});
+        }
+        std::lock_guard<std::mutex> lock{reload_mutex_};
+        env_.swap(env);
+        hash_.valid = false;
+    }
+
+    // transform and check lazy options at parse time
+    void set_eager(bool eager)
+    {
+        std::lock_guard<std::mutex> lock{reload_mutex_};
+        eager_ = eager;
+        hash_.valid = false;
+    }
+
+    void add_callback(void (*cb)())
+    {
+        std::lock_guard<std::mutex> lock{reload_mutex_};
+        callbacks_.push_back(cb);
+    }
+
+    // called after the section is parsed on its own and after full parses
+    // unless the section is detached, full parses keep its options then
+    void add_callback(std::string section, void (*cb)())
+    {
+        std::lock_guard<std::mutex> lock{reload_mutex_};
+        section_callbacks_.emplace_back(std::move(section), cb);
+    }
+
+    // listener is never notified after remove_listener() returns
+    void add_listener(commit_listener *listener)
+    {
+        std::lock_guard<std::mutex> lock{reload_mutex_};
+        listeners_.push_back(listener);
+    }
+
+    void remove_listener(commit_listener *listener)
+    {
+        std::lock_guard<std::mutex> lock{reload_mutex_};
+        listeners_.erase(std::remove(listeners_.begin(), listeners_.end(), listener), listeners_.end());
     }
 
     struct callback
@@ -236,68 +1246,574 @@ public:
         {
             this_type::instance().add_callback(cb);
         }
+
+        callback(std::string section, void (*cb)())
+        {
+            this_type::instance().add_callback(std::move(section), cb);
+        }
     };
 
+    class overlay;
+
+    template<class F>
+    class derived;
+
+#if __cplusplus >= 202002L
+    class change_awaiter;
+
+    // co_await cfg.changed<option::port>(post) suspends the coroutine until
+    // a generation with a new T option is committed. The committing thread
+    // calls post(handle) which should schedule handle.resume() on the
+    // coroutine's executor and must not throw.
+    template<class T>
+    change_awaiter changed(std::function<void(std::coroutine_handle<>)> post)
+    {
+        return change_awaiter{*this, index<T>::index, std::move(post)};
+    }
+#endif
+
 private:
-    config() = default;
+    using snapshot_type = detail::snapshot<Ts...>;
+
+    template<class T>
+    using index = detail::find_type<0, T, Ts...>;
+
+    config();
+
     config(config const&) = delete;
     config& operator = (config const&) = delete;
     config(config&&) = delete;
     config& operator = (config&&) = delete;
 
-    void parse_cmd_line_impl(int argc, const char* const argv[])
+    // Defined out of the class like the parsing functions, so units
+    // seeing RACONFIG_EXTERN_CONFIG don't instantiate option operations.
+    static detail::option_ops const* ops() noexcept;
+
+    // Thread calling get() or quiescent(), it pins the snapshot it has
+    // seen last. Threads calling quiescent() are registered by the first
+    // call, snapshots replaced by commits are retired until every
+    // registered reader is quiescent since.
+    struct reader
     {
-        std::tuple<Ts...> tmp;
-        detail::options_parser p{"Allowed options"};
-        p.add("help", "Show this message and exit");
-#ifdef RACONFIG_VERSION_STRING
-        p.add("version", "Show version and exit");
+        explicit reader(this_type const& cfg) noexcept
+            : cfg{cfg}
+        {}
+
+        reader(reader const&) = delete;
+        reader& operator = (reader const&) = delete;
+
+        ~reader()
+        {
+            if (registered)
+                cfg.remove_reader(*this);
+        }
+
+        this_type const& cfg;
+        bool registered = false;
+        unsigned long generation = 0;
+        std::shared_ptr<snapshot_type const> options;
+        // the thread holds no references to snapshots retired by commits
+        // up to this generation
+        std::atomic<unsigned long> quiescent{0};
+    };
+
+    reader& local_reader() const noexcept
+    {
+        static thread_local reader r{*this};
+        return r;
+    }
+
+    // fast path is a single atomic load
+    snapshot_type const& snapshot() const noexcept
+    {
+        auto& r = local_reader();
+        if (r.generation != generation_.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock{snapshot_mutex_};
+            r.options = replicas_.empty() ? options_ : replica(detail::numa_node());
+            r.generation = generation_.load(std::memory_order_relaxed);
+        }
+        return *r.options;
+    }
+
+    void add_reader(reader& r) const
+    {
+        std::lock_guard<std::mutex> lock{snapshot_mutex_};
+        readers_.push_back(&r);
+        r.registered = true;
+    }
+
+    void remove_reader(reader& r) const
+    {
+        std::vector<std::shared_ptr<snapshot_type const>> released;
+        std::lock_guard<std::mutex> lock{snapshot_mutex_};
+        readers_.erase(std::remove(readers_.begin(), readers_.end(), &r), readers_.end());
+        released = reclaim();
+        // released snapshots are destroyed after the lock is unlocked
+    }
+
+    // Retired snapshots no reader can use any more, in retirement order.
+    // Called under snapshot_mutex_.
+    std::vector<std::shared_ptr<snapshot_type const>> reclaim() const
+    {
+        unsigned long oldest = std::numeric_limits<unsigned long>::max();
+        for (auto r: readers_)
+            oldest = std::min(oldest, r->quiescent.load(std::memory_order_acquire));
+        std::vector<std::shared_ptr<snapshot_type const>> released;
+        auto it = retired_.begin();
+        for (; it != retired_.end() && it->first <= oldest; ++it)
+            released.push_back(std::move(it->second));
+        retired_.erase(retired_.begin(), it);
+        return released;
+    }
+
+    std::shared_ptr<snapshot_type const> load() const
+    {
+        std::lock_guard<std::mutex> lock{snapshot_mutex_};
+        return options_;
+    }
+
+    void publish(std::shared_ptr<snapshot_type const> options)
+    {
+        std::vector<std::shared_ptr<snapshot_type const>> replicas;
+        if (numa_replicas_)
+            replicas = replicate(*options);
+        unsigned long generation;
+        std::vector<std::shared_ptr<snapshot_type const>> released;
+        {
+            std::lock_guard<std::mutex> lock{snapshot_mutex_};
+            options_.swap(options);
+            replicas_.swap(replicas);
+            generation = generation_.fetch_add(1, std::memory_order_release) + 1;
+            retired_.emplace_back(generation, std::move(options));
+            for (auto& r: replicas)
+                if (r)
+                    retired_.emplace_back(generation, std::move(r));
+            released = reclaim();
+        }
+        for (auto listener: listeners_)
+            listener->committed(generation);
+#if __cplusplus >= 202002L
+        wake(*options_);
 #endif
-        p.add("show-config", "Show final configuration and exit");
-        p.add("config", "Load options from file, command line options override ones from file",
-              boost::program_options::value<std::string>());
-        RACONFIG_FOLD(!detail::get<Ts>(tmp)(detail::cmd_name{}) ? (void)0
-                      : p.add(detail::get<Ts>(tmp)(detail::cmd_name{}),
-                              detail::get<Ts>(tmp)(detail::description{}),
-                              boost::program_options::value(&*detail::get<Ts>(tmp))));
-        p.parse_command_line(argc, argv);
-
-        if (p.has("help"))
-            Actions{}.help(p);
+        // unused snapshots are destroyed outside of the lock
+        released.clear();
+    }
+
+    std::shared_ptr<snapshot_type const> const& replica(size_t node) const noexcept
+    {
+        return node < replicas_.size() && replicas_[node] ? replicas_[node] : options_;
+    }
+
+    // Options are copied by a thread bound to the node, so their memory is
+    // allocated and first touched there. Options shared with the previous
+    // snapshot reuse their previous replicas.
+    std::vector<std::shared_ptr<snapshot_type const>> replicate(snapshot_type const& next) const;
+
+    void parse_cmd_line_locked(int argc, const char* const argv[],
+                               detail::config_source const* source = nullptr)
+    {
+        const char* no_args[] = {""};
+        if (argc == 0) {
+            argc = 1;
+            argv = no_args;
+        }
+        detail::input_hash hash;
+        detail::translate_exceptions([&]() { parse_cmd_line_impl(argc, argv, source, hash); });
+        args_.assign(argv, argv + argc);
+        reloadable_ = source == nullptr;
+        hash_ = std::move(hash);
+        for (auto cb: callbacks_)
+            cb();
+        // detached sections are kept as is by a full parse
+        for (auto const& cb: section_callbacks_)
+            if (find_section(cb.first) == sections_.end())
+                cb.second();
+    }
+
+    void parse_section_locked(std::string const& section, detail::config_source const& source);
+
+    std::vector<detail::section_source>::iterator find_section(std::string const& section)
+    {
+        return std::find_if(sections_.begin(), sections_.end(),
+                            [&section](detail::section_source const& s) { return s.name == section; });
+    }
+
+    void parse_cmd_line_impl(int argc, const char* const argv[], detail::config_source const* source,
+                             detail::input_hash& hash);
+
+    struct derivation
+    {
+        virtual std::shared_ptr<void const> derive(snapshot_type const& prev, snapshot_type const& next,
+                                                   size_t id) const = 0;
+
+    protected:
+        ~derivation() = default;
+    };
+
+    // derived values are computed before the snapshot is published, a
+    // failed computation fails the parse
+    void derive(snapshot_type const& prev, snapshot_type& next) const
+    {
+        next.derived.resize(derivations_.size());
+        for (size_t id = 0; id < derivations_.size(); ++id)
+            if (derivations_[id])
+                next.derived[id] = derivations_[id]->derive(prev, next, id);
+    }
+
+    size_t add_derivation(derivation const *d)
+    {
+        std::lock_guard<std::mutex> lock{reload_mutex_};
+        derivations_.push_back(d);
+        auto const prev = load();
+        auto next = std::make_shared<snapshot_type>(*prev);
+        try {
+            detail::translate_exceptions([&]() { derive(*prev, *next); });
+        } catch (...) {
+            derivations_.pop_back();
+            throw;
+        }
+        publish(std::move(next));
+        return derivations_.size() - 1;
+    }
+
+    void remove_derivation(size_t id)
+    {
+        std::lock_guard<std::mutex> lock{reload_mutex_};
+        derivations_[id] = nullptr;
+    }
+
+#if __cplusplus >= 202002L
+    struct waiter
+    {
+        size_t index;
+        // option seen before suspension
+        std::shared_ptr<void const> option;
+        std::coroutine_handle<> handle;
+        std::function<void(std::coroutine_handle<>)> post;
+    };
+
+    // false if the option has changed already
+    bool wait(waiter& w)
+    {
+        std::lock_guard<std::mutex> lock{waiters_mutex_};
+        if (load()->options[w.index] != w.option)
+            return false;
+        waiters_.push_back(&w);
+        return true;
+    }
+
+    void cancel(waiter& w)
+    {
+        std::lock_guard<std::mutex> lock{waiters_mutex_};
+        waiters_.erase(std::remove(waiters_.begin(), waiters_.end(), &w), waiters_.end());
+    }
+
+    // posted under the lock, so a destroyed coroutine is either not
+    // waiting or has been posted already
+    void wake(snapshot_type const& next) noexcept
+    {
+        std::lock_guard<std::mutex> lock{waiters_mutex_};
+        for (auto it = waiters_.begin(); it != waiters_.end();) {
+            auto const w = *it;
+            if (next.options[w->index] != w->option) {
+                it = waiters_.erase(it);
+                w->post(w->handle);
+            } else {
+                ++it;
+            }
+        }
+    }
+#endif
+
+    std::mutex reload_mutex_;
+    mutable std::mutex snapshot_mutex_;
+    // registered reader threads and retired snapshots with the generations
+    // which replaced them, guarded by snapshot_mutex_
+    mutable std::vector<reader*> readers_;
+    mutable std::vector<std::pair<unsigned long, std::shared_ptr<snapshot_type const>>> retired_;
+    std::atomic<unsigned long> generation_{1};
+    std::shared_ptr<snapshot_type const> options_;
+    // per NUMA node copies of options_, empty unless enabled
+    std::vector<std::shared_ptr<snapshot_type const>> replicas_;
+    std::vector<derivation const*> derivations_;
+    std::vector<std::string> args_;
+    std::vector<void(*)()> callbacks_;
+    std::vector<std::pair<std::string, void(*)()>> section_callbacks_;
+    std::vector<detail::section_source> sections_;
+    std::unique_ptr<detail::env_source> env_;
+    std::vector<commit_listener*> listeners_;
+    bool eager_ = false;
+    bool numa_replicas_ = false;
+    bool reloadable_ = true;
+    detail::input_hash hash_;
+#ifdef RACONFIG_TRACE_ACCESS
+    detail::access_counters accesses_{sizeof...(Ts)};
+#endif
+#if __cplusplus >= 202002L
+    std::mutex waiters_mutex_;
+    std::vector<waiter*> waiters_;
+#endif
+};
+
+template<class Actions, class ...Ts>
+config<Actions, Ts...>::config()
+    : options_{std::make_shared<snapshot_type>()}
+{
+    auto& options = const_cast<snapshot_type&>(*options_).options;
+    RACONFIG_FOLD(std::get<index<Ts>::index>(options) = std::make_shared<Ts>());
+}
+
+template<class Actions, class ...Ts>
+detail::option_ops const* config<Actions, Ts...>::ops() noexcept
+{
+    static constexpr std::array<detail::option_ops, sizeof...(Ts)> table{{
+        detail::make_option_ops<Ts>()...
+    }};
+    return table.data();
+}
+
+template<class Actions, class ...Ts>
+auto config<Actions, Ts...>::replicate(snapshot_type const& next) const
+    -> std::vector<std::shared_ptr<snapshot_type const>>
+{
+    std::vector<std::shared_ptr<snapshot_type const>> replicas(detail::numa_nodes());
+    detail::run_on_numa_nodes([&](size_t node) {
+        auto replica = std::make_shared<snapshot_type>(next);
+        auto const prev = node < replicas_.size() ? replicas_[node].get() : nullptr;
+        for (size_t i = 0; i < sizeof...(Ts); ++i) {
+            auto& slot = replica->options[i];
+            if (ops()[i].copy == nullptr)
+                continue;
+            if (prev && options_->options[i] == slot)
+                slot = prev->options[i];
+            else
+                slot = ops()[i].copy(slot.get());
+        }
+        replicas[node] = std::move(replica);
+    });
+    return replicas;
+}
+
+template<class Actions, class ...Ts>
+void config<Actions, Ts...>::parse_section_locked(std::string const& section,
+                                                  detail::config_source const& source)
+{
+    std::vector<const char*> argv;
+    for (auto const& arg: args_)
+        argv.push_back(arg.c_str());
+    if (argv.empty())
+        argv.push_back("");
+    detail::translate_exceptions([&]() {
+        auto const prev = load();
+        auto next = std::make_shared<snapshot_type>();
+        detail::parse_context const context{ops(), sizeof...(Ts),
+            prev->options.data(), prev->inputs.data(), prev->parsed,
+            next->options.data(), next->inputs.data(), eager_, section.c_str(), nullptr, env_.get()};
+        Actions actions;
+        detail::input_hash hash;
+        detail::parse_options(context, static_cast<int>(argv.size()), argv.data(), &source,
+                              nullptr, actions, hash);
+        derive(*prev, *next);
+        next->parsed = true;
+        publish(next);
+    });
+    auto const it = find_section(section);
+    std::string path = source.path ? source.path : "";
+    if (it == sections_.end())
+        sections_.push_back(detail::section_source{section, std::move(path)});
+    else
+        it->path = std::move(path);
+    for (auto const& cb: section_callbacks_)
+        if (cb.first == section)
+            cb.second();
+}
+
+template<class Actions, class ...Ts>
+void config<Actions, Ts...>::parse_cmd_line_impl(int argc, const char* const argv[],
+                                                 detail::config_source const* source,
+                                                 detail::input_hash& hash)
+{
 #ifdef RACONFIG_VERSION_STRING
-        if (p.has("version"))
-            Actions{}.version(RACONFIG_VERSION_STRING);
+    const char *version = RACONFIG_VERSION_STRING;
+#else
+    const char *version = nullptr;
 #endif
-        std::string config;
-        if (p.get("config", config)) {
-            detail::options_parser p;
-            RACONFIG_FOLD(!detail::get<Ts>(tmp)(detail::cfg_name{}) ? (void)0
-                          : p.add(detail::get<Ts>(tmp)(detail::cfg_name{}),
-                                  detail::get<Ts>(tmp)(detail::description{}),
-                                  boost::program_options::value(&*detail::get<Ts>(tmp))));
-            p.parse_config_file(config.c_str());
-            p.notify();
+    auto const prev = load();
+    auto next = std::make_shared<snapshot_type>();
+    detail::parse_context const context{ops(), sizeof...(Ts),
+        prev->options.data(), prev->inputs.data(), prev->parsed,
+        next->options.data(), next->inputs.data(), eager_, nullptr, &sections_, env_.get()};
+    Actions actions;
+    auto const res = detail::parse_options(context, argc, argv, source, version, actions, hash);
+    derive(*prev, *next);
+    next->parsed = true;
+    publish(next);
+
+    if (res.show_config)
+        detail::show_config(actions, ops(), next->options.data(), sizeof...(Ts));
+    if (res.show_memory)
+        detail::show_memory(actions, ops(), next->options.data(), sizeof...(Ts));
+}
+
+// Configuration object sharing all options but overridden ones with
+// a base snapshot, so memory grows with the number of overrides only.
+// Overrides are command line style arguments. The base snapshot is
+// pinned at construction and is not affected by later reloads.
+template<class Actions, class ...Ts>
+class config<Actions, Ts...>::overlay
+{
+public:
+    explicit overlay(this_type const& base = this_type::instance())
+        : base_{base.load()}
+    {}
+
+    overlay(this_type const& base, int argc, const char* const argv[])
+        : overlay{base}
+    {
+        apply(argc, argv);
+    }
+
+    overlay(overlay const& base, int argc, const char* const argv[])
+        : overlay{base}
+    {
+        apply(argc, argv);
+    }
+
+    template<class T>
+    RACONFIG_VALUE_TYPE(T) const& get() const
+        noexcept(noexcept(std::declval<T const&>()(detail::get_user_type{})))
+    {
+        return option<T>()(detail::get_user_type{});
+    }
+
+    size_t overrides() const noexcept { return overrides_.size(); }
+
+private:
+    template<class T>
+    T const& option() const noexcept
+    {
+        constexpr size_t i = detail::find_type<0, T, Ts...>::index;
+        if (mask_[i]) {
+            for (auto const& o: overrides_)
+                if (o.first == i)
+                    return *static_cast<T const*>(o.second.get());
         }
+        return detail::get<T>(*base_);
+    }
+
+    void apply(int argc, const char* const argv[])
+    {
+        detail::translate_exceptions([&]() {
+            detail::parse_overrides(this_type::ops(), base_->options.data(), sizeof...(Ts),
+                                    argc, argv, overrides_);
+        });
+        for (auto const& o: overrides_)
+            mask_.set(o.first);
+    }
 
-        // notify command line options after config
-        p.notify();
-        RACONFIG_FOLD(detail::get<Ts>(tmp)(detail::transform_backend{}));
-        RACONFIG_FOLD(detail::get<Ts>(tmp)(detail::check_value{}));
-        options_ = std::move(tmp);
-        if (p.has("show-config")) {
-            Actions actions;
-            actions.show_config_begin();
-            RACONFIG_FOLD(detail::show_option(actions, detail::get<Ts>(options_)));
-            actions.show_config_end();
+    std::shared_ptr<snapshot_type const> base_;
+    std::bitset<sizeof...(Ts)> mask_;
+    std::vector<std::pair<size_t, std::shared_ptr<void const>>> overrides_;
+};
+
+// Value computed by a user function from some options. It is computed
+// once per generation before the snapshot is published and is stored in
+// the snapshot, recomputed only if any of its options has changed.
+// Should be constructed before the configuration is parsed, its value
+// is computed right away.
+template<class Actions, class ...Ts>
+template<class R, class ...Os>
+class config<Actions, Ts...>::derived<R(Os...)>: derivation
+{
+    static_assert(sizeof...(Os) > 0, "Derived value should depend on options");
+
+public:
+    template<class F>
+    explicit derived(F f)
+        : f_{std::move(f)}
+        , id_{this_type::instance().add_derivation(this)}
+    {}
+
+    derived(derived const&) = delete;
+    derived& operator = (derived const&) = delete;
+
+    ~derived()
+    {
+        this_type::instance().remove_derivation(id_);
+    }
+
+    R const& get() const noexcept
+    {
+        return *static_cast<R const*>(this_type::instance().snapshot().derived[id_].get());
+    }
+
+private:
+    std::shared_ptr<void const> derive(snapshot_type const& prev, snapshot_type const& next,
+                                       size_t id) const override
+    {
+        if (id < prev.derived.size() && prev.derived[id]) {
+            bool same = true;
+            RACONFIG_FOLD(same = same && std::get<index<Os>::index>(prev.options) ==
+                                         std::get<index<Os>::index>(next.options));
+            if (same)
+                return prev.derived[id];
         }
+        return std::make_shared<R const>(f_(detail::get<Os>(next)(detail::get_user_type{})...));
     }
 
-    std::tuple<Ts...> options_;
-    std::vector<void(*)()> callbacks_;
+    std::function<R(detail::user_type<Os> const&...)> f_;
+    size_t const id_;
 };
 
+#if __cplusplus >= 202002L
+// Awaitable returned by config::changed(), the option it waits for to
+// change is the one seen at construction.
+template<class Actions, class ...Ts>
+class config<Actions, Ts...>::change_awaiter: waiter
+{
+public:
+    change_awaiter(change_awaiter const&) = delete;
+    change_awaiter& operator = (change_awaiter const&) = delete;
+
+    ~change_awaiter()
+    {
+        cfg_.cancel(*this);
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        this->handle = handle;
+        return cfg_.wait(*this);
+    }
+
+    void await_resume() const noexcept {}
+
+private:
+    friend this_type;
+
+    change_awaiter(this_type& cfg, size_t index, std::function<void(std::coroutine_handle<>)> post)
+        : waiter{index, cfg.load()->options[index], {}, std::move(post)}
+        , cfg_{cfg}
+    {}
+
+    this_type& cfg_;
+};
+#endif
+
 } // namespace raconfig
 
+// Explicit instantiation of a configuration type: put
+// RACONFIG_EXTERN_CONFIG(actions, options...); next to the declaration
+// of the config type and RACONFIG_INSTANTIATE_CONFIG(actions, options...);
+// into one translation unit, at global scope. Option operations and
+// parsing are compiled in that unit only, others compile just what they
+// call inline like get<T>(). RACONFIG_VERSION_STRING of the instantiating
+// unit is used.
+#define RACONFIG_EXTERN_CONFIG(...) extern template class raconfig::config<__VA_ARGS__>
+#define RACONFIG_INSTANTIATE_CONFIG(...) template class raconfig::config<__VA_ARGS__>
+
 #ifndef RACONFIG_LIB
 #define RACONFIG_INLINE inline
 #include "raconfig.ipp"
@@ -307,24 +1823,40 @@ private:
 #define RACONFIG_V(...) __VA_ARGS__
 #define RACONFIG_NO_NAME nullptr
 
-#define RACONFIG_OPTION_CHECKED(tag, type, default_value, pred, cmd_name_, cfg_name_, description_) \
-    struct tag final: raconfig::detail::option_value<type> \
+#define RACONFIG_DETAIL_OPTION(tag, base, default_value, pred, cmd_name_, cfg_name_, description_) \
+    struct tag final: base \
     { \
-        using raconfig::detail::option_value<type>::operator (); \
+        using base::operator (); \
         const char* operator ()(raconfig::detail::name) const noexcept { return #tag; } \
         const char* operator ()(raconfig::detail::cmd_name) const noexcept { return (cmd_name_); } \
         const char* operator ()(raconfig::detail::cfg_name) const noexcept { return (cfg_name_); } \
         const char* operator ()(raconfig::detail::description) const noexcept { return (description_); } \
-        void operator ()(raconfig::detail::check_value) const \
+        template<class V> \
+        void operator ()(raconfig::detail::check_value, V const& v) const \
         { \
-            auto& v = (*this)(raconfig::detail::get_user_type{}); \
-            if (!(pred)(v)) \
+            if (!raconfig::detail::value_validity<V>::valid(v) || !(pred)(v)) \
                 raconfig::detail::throw_option_check_failed(#tag, \
                         raconfig::detail::to_string(v).c_str());  \
         } \
-        tag(): raconfig::detail::option_value<type>{default_value} {} \
+        void operator ()(raconfig::detail::check_value) const \
+        { \
+            (*this)(raconfig::detail::check_value{}, (*this)(raconfig::detail::get_unchecked{})); \
+        } \
+        tag(): base{default_value} {} \
     };
 
+#define RACONFIG_OPTION_CHECKED(tag, type, default_value, pred, cmd_name_, cfg_name_, description_) \
+    RACONFIG_DETAIL_OPTION(tag, RACONFIG_T(raconfig::detail::option_value<type>), \
+            RACONFIG_V(default_value), RACONFIG_V(pred), cmd_name_, cfg_name_, description_)
+
+#define RACONFIG_OPTION_LAZY_CHECKED(tag, type, default_value, pred, cmd_name_, cfg_name_, description_) \
+    RACONFIG_DETAIL_OPTION(tag, RACONFIG_T(raconfig::detail::lazy_option_value<tag, type>), \
+            RACONFIG_V(default_value), RACONFIG_V(pred), cmd_name_, cfg_name_, description_)
+
+#define RACONFIG_OPTION_LAZY(tag, type, default_value, cmd_name_, cfg_name_, description_) \
+    RACONFIG_OPTION_LAZY_CHECKED(tag, RACONFIG_T(type), RACONFIG_V(default_value), \
+            raconfig::detail::skip_option_check, cmd_name_, cfg_name_, description_)
+
 #define RACONFIG_OPTION(tag, type, default_value, cmd_name_, cfg_name_, description_) \
     RACONFIG_OPTION_CHECKED(tag, RACONFIG_T(type), RACONFIG_V(default_value), \
             raconfig::detail::skip_option_check, cmd_name_, cfg_name_, description_)
@@ -20,12 +20,33 @@
 #include <boost/program_options/options_description.hpp>
 #include <boost/program_options/variables_map.hpp>
 #include <boost/program_options/parsers.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <streambuf>
+#include <thread>
+#include <unordered_map>
+#ifdef RACONFIG_POSIX
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sched.h>
+#endif
 
 #ifndef RACONFIG_INLINE
 #define RACONFIG_INLINE
 #endif
 
+#ifdef RACONFIG_POSIX
+extern char **environ;
+#endif
+
 namespace raconfig
 {
 
@@ -46,13 +67,23 @@ struct options_parser::impl
     impl(const char *header)
         : desc{header}
         , init{&desc}
+        , parsed{nullptr}
     {}
 
     po::options_description desc;
     po::options_description_easy_init init;
+    po::parsed_options parsed;
+    std::vector<std::string> skipped;
     po::variables_map vm;
 };
 
+// option key without short name suffix
+RACONFIG_INLINE std::string option_key(const char *name)
+{
+    const char *comma = std::strchr(name, ',');
+    return comma ? std::string{name, comma} : std::string{name};
+}
+
 RACONFIG_INLINE options_parser::options_parser(const char *header)
 {
     impl_ = new impl{header};
@@ -66,38 +97,261 @@ RACONFIG_INLINE void options_parser::add(const char *name, const char *descripti
         impl_->init(name, s, description);
 }
 
+// Single pass tokenizer for the common forms of the default command line
+// style: --name=value, --name value, --switch, -xvalue, -x value. All
+// occurrences of a list option are merged into one entry, so they are
+// converted at once. Returns false for anything else (abbreviations,
+// grouped short switches, positional or unknown arguments, errors), such
+// command lines are left to boost.
+RACONFIG_INLINE bool tokenize_command_line(int argc, const char* const argv[],
+                                           po::options_description const& desc,
+                                           po::parsed_options& parsed)
+{
+    std::unordered_map<std::string, size_t> lists;
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        if (arg[0] != '-' || arg[1] == '\0')
+            return false;
+        std::string name;
+        const char *value = nullptr;
+        if (arg[1] == '-') {
+            const char *eq = std::strchr(arg + 2, '=');
+            name.assign(arg + 2, eq ? eq : arg + std::strlen(arg));
+            if (eq)
+                value = eq + 1;
+        } else {
+            name.assign(arg, 2);
+            if (arg[2] != '\0')
+                value = arg + 2;
+        }
+        if (name.empty())
+            return false;
+        auto const d = desc.find_nothrow(name, false, false, false);
+        if (d == nullptr)
+            return false;
+        auto const& semantic = *d->semantic();
+        // boost requires a value right after '='
+        if (value && (semantic.max_tokens() == 0 || *value == '=' || *value == '\0'))
+            return false;
+        po::option opt{d->key(name), {}};
+        opt.original_tokens.push_back(arg);
+        if (value) {
+            opt.value.push_back(value);
+        } else if (semantic.min_tokens() > 0) {
+            if (i + 1 == argc || argv[i + 1][0] == '-')
+                return false;
+            opt.value.push_back(argv[++i]);
+            opt.original_tokens.push_back(argv[i]);
+        }
+        if (dynamic_cast<list_semantic const*>(&semantic) == nullptr) {
+            parsed.options.push_back(std::move(opt));
+            continue;
+        }
+        auto const it = lists.emplace(opt.string_key, parsed.options.size());
+        if (it.second) {
+            parsed.options.push_back(std::move(opt));
+        } else {
+            auto& list = parsed.options[it.first->second];
+            std::move(opt.value.begin(), opt.value.end(), std::back_inserter(list.value));
+        }
+    }
+    return true;
+}
+
 RACONFIG_INLINE void options_parser::parse_command_line(int argc, const char* const argv[])
 {
     impl_->vm.clear();
-    po::store(po::parse_command_line(argc, argv, impl_->desc), impl_->vm);
+    impl_->skipped.clear();
+    po::parsed_options parsed{&impl_->desc, po::command_line_style::allow_long};
+    if (tokenize_command_line(argc, argv, impl_->desc, parsed))
+        impl_->parsed = std::move(parsed);
+    else
+        impl_->parsed = po::parse_command_line(argc, argv, impl_->desc);
 }
 
 RACONFIG_INLINE void options_parser::parse_config_file(const char *path)
 {
     impl_->vm.clear();
-    po::store(po::parse_config_file<char>(path, impl_->desc, false), impl_->vm);
+    impl_->skipped.clear();
+    impl_->parsed = po::parse_config_file<char>(path, impl_->desc, false);
+}
+
+// read-only stream buffer over memory
+class memory_streambuf: public std::streambuf
+{
+public:
+    memory_streambuf(const char *data, size_t size)
+    {
+        char *p = const_cast<char*>(data);
+        setg(p, p, p + size);
+    }
+};
+
+#ifdef RACONFIG_POSIX
+// stream buffer reading a file descriptor by chunks
+class fd_streambuf: public std::streambuf
+{
+public:
+    explicit fd_streambuf(int fd)
+        : fd_{fd}
+    {}
+
+protected:
+    int_type underflow() override
+    {
+        ssize_t n;
+        while ((n = ::read(fd_, buf_, sizeof buf_)) < 0 && errno == EINTR);
+        if (n < 0)
+            throw_system_error("cannot read configuration");
+        if (n == 0)
+            return traits_type::eof();
+        setg(buf_, buf_, buf_ + n);
+        return traits_type::to_int_type(buf_[0]);
+    }
+
+private:
+    int fd_;
+    char buf_[65536];
+};
+
+RACONFIG_INLINE void options_parser::parse_config_buffer(const char *data, size_t size)
+{
+    memory_streambuf buf{data, size};
+    std::istream is{&buf};
+    impl_->vm.clear();
+    impl_->skipped.clear();
+    impl_->parsed = po::parse_config_file(is, impl_->desc, false);
+}
+
+RACONFIG_INLINE void options_parser::parse_config_fd(int fd)
+{
+    fd_streambuf buf{fd};
+    std::istream is{&buf};
+    is.exceptions(std::ios_base::badbit);
+    impl_->vm.clear();
+    impl_->skipped.clear();
+    impl_->parsed = po::parse_config_file(is, impl_->desc, false);
+}
+#endif
+
+// NAME=value entries of the process environment, nullptr if unknown
+RACONFIG_INLINE char** process_environment() noexcept
+{
+#if defined(RACONFIG_POSIX)
+    return environ;
+#elif defined(_WIN32)
+    return _environ;
+#else
+    return nullptr;
+#endif
+}
+
+// Call f(entry, value, config file name) for every environment variable
+// of an option: a single pass over environ with a hash lookup per
+// variable having the prefix.
+template<class F>
+void for_each_env(env_source const& env, F f)
+{
+    size_t const n = env.prefix.size();
+    std::string key;
+    for (char **e = process_environment(); e && *e; ++e) {
+        const char *entry = *e;
+        if (std::strncmp(entry, env.prefix.c_str(), n) != 0)
+            continue;
+        const char *eq = std::strchr(entry + n, '=');
+        if (eq == nullptr)
+            continue;
+        key.assign(entry + n, eq);
+        auto const it = env.names.find(key);
+        if (it != env.names.end())
+            f(entry, eq + 1, it->second);
+    }
+}
+
+RACONFIG_INLINE void options_parser::parse_environment(env_source const& env)
+{
+    po::parsed_options parsed{&impl_->desc};
+    for_each_env(env, [&parsed](const char *entry, const char *value, const char *name) {
+        po::option opt{name, {value}};
+        opt.original_tokens.push_back(entry);
+        parsed.options.push_back(std::move(opt));
+    });
+    impl_->vm.clear();
+    impl_->skipped.clear();
+    impl_->parsed = std::move(parsed);
+}
+
+RACONFIG_INLINE uint64_t hash_environment(env_source const& env, uint64_t seed)
+{
+    for_each_env(env, [&seed](const char *entry, const char*, const char*) {
+        seed = hash_bytes(entry, std::strlen(entry) + 1, seed);
+    });
+    return seed;
 }
 
-RACONFIG_INLINE void options_parser::notify()
+RACONFIG_INLINE void options_parser::skip(const char *name)
 {
-    po::notify(impl_->vm);
+    impl_->skipped.push_back(option_key(name));
+}
+
+RACONFIG_INLINE void options_parser::store()
+{
+    auto& options = impl_->parsed.options;
+    auto const& skipped = impl_->skipped;
+    options.erase(std::remove_if(options.begin(), options.end(), [&](po::option const& o) {
+        return std::find(skipped.begin(), skipped.end(), o.string_key) != skipped.end();
+    }), options.end());
+    if (impl_->parsed.description != nullptr)
+        po::store(impl_->parsed, impl_->vm);
 }
 
 RACONFIG_INLINE bool options_parser::has(const char *name) const
 {
-    return impl_->vm.count(name) > 0;
+    auto const key = option_key(name);
+    for (auto const& o: impl_->parsed.options)
+        if (o.string_key == key)
+            return true;
+    return false;
 }
 
 RACONFIG_INLINE bool options_parser::get(const char *name, std::string& value) const
 {
-    po::variable_value const& vv = impl_->vm[name];
-    if (!vv.empty()) {
-        value = vv.as<std::string>();
-        return true;
+    auto const key = option_key(name);
+    auto const& options = impl_->parsed.options;
+    for (auto it = options.rbegin(); it != options.rend(); ++it) {
+        if (it->string_key == key && !it->value.empty()) {
+            value = it->value.front();
+            return true;
+        }
     }
     return false;
 }
 
+RACONFIG_INLINE uint64_t options_parser::digest(const char *name) const
+{
+    auto const key = option_key(name);
+    uint64_t h = 0;
+    bool found = false;
+    for (auto const& o: impl_->parsed.options) {
+        if (o.string_key != key)
+            continue;
+        found = true;
+        uint64_t const n = o.value.size();
+        h = hash_bytes(&n, sizeof n, h);
+        for (auto const& token: o.value)
+            h = hash_bytes(token.data(), token.size(), h);
+    }
+    return !found ? 0 : h > runtime_input ? h : runtime_input + 1;
+}
+
+RACONFIG_INLINE boost::any* options_parser::value(const char *name)
+{
+    auto it = impl_->vm.find(option_key(name));
+    if (it == impl_->vm.end() || it->second.empty())
+        return nullptr;
+    return &it->second.value();
+}
+
 RACONFIG_INLINE options_parser::operator po::options_description const& () const noexcept
 {
     return impl_->desc;
@@ -108,6 +362,342 @@ RACONFIG_INLINE options_parser::~options_parser()
     delete impl_;
 }
 
+RACONFIG_INLINE std::vector<option_names> describe_options(option_ops const *ops,
+                                                          std::shared_ptr<void const> const *options,
+                                                          size_t size)
+{
+    std::vector<option_names> names(size);
+    for (size_t i = 0; i < size; ++i)
+        ops[i].names(options[i].get(), names[i]);
+    return names;
+}
+
+RACONFIG_INLINE env_source make_env_source(const char *prefix, option_ops const *ops,
+                                           std::shared_ptr<void const> const *options, size_t size)
+{
+    env_source env;
+    env.prefix.append(prefix).append("_");
+    for (auto const& names: describe_options(ops, options, size)) {
+        if (names.cfg_name == nullptr)
+            continue;
+        std::string key = names.cfg_name;
+        for (auto& ch: key)
+            ch = ch == '.' || ch == '-' ? '_' : static_cast<char>(std::toupper(static_cast<unsigned char>(ch)));
+        auto const it = env.names.emplace(key, names.cfg_name);
+        if (!it.second)
+            throw config_error{"options '" + std::string{it.first->second} + "' and '" + names.cfg_name +
+                               "' have the same environment variable " + env.prefix + key};
+    }
+    return env;
+}
+
+RACONFIG_INLINE void add_options(options_parser& p, option_ops const *ops,
+                                 std::vector<option_names> const& names, bool file)
+{
+    for (size_t i = 0; i < names.size(); ++i) {
+        const char *name = file ? names[i].cfg_name : names[i].cmd_name;
+        if (name)
+            p.add(name, names[i].description, ops[i].semantic());
+    }
+}
+
+// The file is hashed before it is parsed, so a file changed in between
+// causes an extra reload rather than a missed one.
+RACONFIG_INLINE void hash_inputs(parse_context const& c, int argc, const char* const argv[],
+                                 const char *config, input_hash& hash)
+{
+    hash.valid = true;
+    hash.args = hash.value = hash_args(argc, argv);
+    if (c.env)
+        hash.value = hash_environment(*c.env, hash.value);
+    if (config) {
+        hash.config = config;
+        hash.valid = hash_file(config, hash.value);
+    }
+}
+
+// section options have config file names "section.*"
+RACONFIG_INLINE bool in_section(option_names const& names, const char *section)
+{
+    size_t const n = std::strlen(section);
+    return names.cfg_name && std::strncmp(names.cfg_name, section, n) == 0 && names.cfg_name[n] == '.';
+}
+
+RACONFIG_INLINE bool is_selected(parse_context const& c, option_names const& names)
+{
+    if (c.section)
+        return in_section(names, c.section);
+    if (c.detached)
+        for (auto const& section: *c.detached)
+            if (in_section(names, section.name.c_str()))
+                return false;
+    return true;
+}
+
+// option is not parsed and is shared with the previous snapshot
+RACONFIG_INLINE void keep_option(parse_context const& c, size_t i, option_names const& names,
+                                 options_parser& cmd, options_parser& env, options_parser& file)
+{
+    c.next[i] = c.prev[i];
+    c.next_inputs[i] = c.prev_inputs[i];
+    if (names.cmd_name)
+        cmd.skip(names.cmd_name);
+    if (names.cfg_name) {
+        env.skip(names.cfg_name);
+        file.skip(names.cfg_name);
+    }
+}
+
+// command line value takes precedence over the environment one, which
+// takes precedence over the file one
+RACONFIG_INLINE void select_option(parse_context const& c, size_t i, option_names const& names,
+                                   options_parser& cmd, options_parser& env, options_parser& file)
+{
+    uint64_t input = names.cmd_name ? cmd.digest(names.cmd_name) : 0;
+    if (input != 0) {
+        if (names.cfg_name) {
+            env.skip(names.cfg_name);
+            file.skip(names.cfg_name);
+        }
+    } else if (names.cfg_name) {
+        input = env.digest(names.cfg_name);
+        if (input != 0)
+            file.skip(names.cfg_name);
+        else
+            input = file.digest(names.cfg_name);
+    }
+    c.next_inputs[i] = input;
+    if (c.ops[i].shareable && c.prev_parsed && c.prev_inputs[i] == input &&
+        (!c.ops[i].unchanged || c.ops[i].unchanged(c.prev[i].get()))) {
+        c.next[i] = c.prev[i];
+        if (names.cmd_name)
+            cmd.skip(names.cmd_name);
+        if (names.cfg_name) {
+            env.skip(names.cfg_name);
+            file.skip(names.cfg_name);
+        }
+    }
+}
+
+RACONFIG_INLINE void make_option(parse_context const& c, size_t i, option_names const& names,
+                                 options_parser& cmd, options_parser& env, options_parser& file)
+{
+    auto& slot = c.next[i];
+    if (slot) {
+        if (c.ops[i].prepare_shared)
+            c.ops[i].prepare_shared(slot.get(), c.eager);
+        return;
+    }
+    boost::any *value = names.cmd_name ? cmd.value(names.cmd_name) : nullptr;
+    if (value == nullptr && names.cfg_name)
+        value = env.value(names.cfg_name);
+    if (value == nullptr && names.cfg_name)
+        value = file.value(names.cfg_name);
+    slot = c.ops[i].make(value, c.eager);
+}
+
+RACONFIG_INLINE parse_result parse_options(parse_context const& c, int argc, const char* const argv[],
+                                           config_source const *source, const char *version,
+                                           default_actions& actions, input_hash& hash)
+{
+    auto const names = describe_options(c.ops, c.prev, c.size);
+    options_parser p{"Allowed options"};
+    p.add("help", "Show this message and exit");
+    if (version)
+        p.add("version", "Show version and exit");
+    p.add("show-config", "Show final configuration and exit");
+    p.add("show-memory", "Show memory used by options and exit");
+    p.add("config", "Load options from file, command line options override ones from file",
+          po::value<std::string>());
+    add_options(p, c.ops, names, false);
+    p.parse_command_line(argc, argv);
+
+    if (!c.section && p.has("help"))
+        actions.help(p);
+    if (!c.section && version && p.has("version"))
+        actions.version(version);
+    options_parser f;
+    std::string config;
+    bool const has_config = !c.section && p.get("config", config);
+    if (has_config && source)
+        throw config_error{"option '--config' can't be used with in-memory configuration"};
+    if (!source)
+        hash_inputs(c, argc, argv, has_config ? config.c_str() : nullptr, hash);
+    if (has_config || source) {
+        add_options(f, c.ops, names, true);
+        if (has_config)
+            f.parse_config_file(config.c_str());
+        else if (source->path)
+            f.parse_config_file(source->path);
+        else if (source->data)
+            f.parse_config_buffer(source->data, source->size);
+#ifdef RACONFIG_POSIX
+        else
+            f.parse_config_fd(source->fd);
+#endif
+    }
+    options_parser e;
+    if (c.env) {
+        add_options(e, c.ops, names, true);
+        e.parse_environment(*c.env);
+    }
+
+    for (size_t i = 0; i < c.size; ++i) {
+        if (is_selected(c, names[i]))
+            select_option(c, i, names[i], p, e, f);
+        else
+            keep_option(c, i, names[i], p, e, f);
+    }
+    f.store();
+    e.store();
+    p.store();
+    for (size_t i = 0; i < c.size; ++i)
+        make_option(c, i, names[i], p, e, f);
+    if (c.section)
+        return parse_result{false, false};
+    return parse_result{p.has("show-config"), p.has("show-memory")};
+}
+
+RACONFIG_INLINE bool section_changed(option_ops const *ops, std::shared_ptr<void const> const *prev,
+                                     std::shared_ptr<void const> const *next, size_t size, const char *section)
+{
+    for (size_t i = 0; i < size; ++i) {
+        if (prev[i] == next[i])
+            continue;
+        option_names names;
+        ops[i].names(next[i].get(), names);
+        if (in_section(names, section))
+            return true;
+    }
+    return false;
+}
+
+RACONFIG_INLINE bool external_unchanged(option_ops const *ops, std::shared_ptr<void const> const *options,
+                                        size_t size)
+{
+    for (size_t i = 0; i < size; ++i)
+        if (ops[i].unchanged && !ops[i].unchanged(options[i].get()))
+            return false;
+    return true;
+}
+
+RACONFIG_INLINE void parse_overrides(option_ops const *ops, std::shared_ptr<void const> const *base, size_t size,
+                                     int argc, const char* const argv[],
+                                     std::vector<std::pair<size_t, std::shared_ptr<void const>>>& overrides)
+{
+    auto const names = describe_options(ops, base, size);
+    options_parser p;
+    add_options(p, ops, names, false);
+    p.parse_command_line(argc, argv);
+    p.store();
+    for (size_t i = 0; i < size; ++i) {
+        boost::any *value = names[i].cmd_name ? p.value(names[i].cmd_name) : nullptr;
+        if (value == nullptr)
+            continue;
+        auto o = ops[i].make(value, false);
+        auto it = std::find_if(overrides.begin(), overrides.end(),
+                               [i](std::pair<size_t, std::shared_ptr<void const>> const& x) { return x.first == i; });
+        if (it != overrides.end())
+            it->second = std::move(o);
+        else
+            overrides.emplace_back(i, std::move(o));
+    }
+}
+
+RACONFIG_INLINE size_t find_option(std::vector<option_names> const& names, std::string const& name)
+{
+    for (size_t i = 0; i < names.size(); ++i) {
+        auto const& n = names[i];
+        if (name == n.name || (n.cmd_name && name == option_key(n.cmd_name)) ||
+            (n.cfg_name && name == n.cfg_name))
+            return i;
+    }
+    return names.size();
+}
+
+// Updates are parsed as a command line, every option is keyed by the
+// first name it is given by
+RACONFIG_INLINE void parse_updates(option_ops const *ops, std::shared_ptr<void const> *options, uint64_t *inputs,
+                                   size_t size, std::vector<std::pair<std::string, std::string>> const& values)
+{
+    auto const names = describe_options(ops, options, size);
+    std::vector<std::string> keys(size);
+    std::vector<std::string> args;
+    options_parser p;
+    for (auto const& v: values) {
+        size_t const i = find_option(names, v.first);
+        if (i == size)
+            throw config_error{"unrecognised option '" + v.first + "'"};
+        if (keys[i].empty()) {
+            keys[i] = v.first;
+            p.add(keys[i].c_str(), names[i].description, ops[i].semantic());
+        }
+        args.push_back("--" + keys[i] + "=" + v.second);
+    }
+    std::vector<const char*> argv{""};
+    for (auto const& arg: args)
+        argv.push_back(arg.c_str());
+    p.parse_command_line(static_cast<int>(argv.size()), argv.data());
+    p.store();
+    for (size_t i = 0; i < size; ++i) {
+        if (keys[i].empty())
+            continue;
+        // lazy options are checked now, an update is not committed unchecked
+        options[i] = ops[i].make(p.value(keys[i].c_str()), true);
+        inputs[i] = runtime_input;
+    }
+}
+
+RACONFIG_INLINE bool find_value(option_ops const *ops, std::shared_ptr<void const> const *options, size_t size,
+                                std::string const& name, std::string& value)
+{
+    size_t const i = find_option(describe_options(ops, options, size), name);
+    if (i == size)
+        return false;
+    value = ops[i].to_string(options[i].get());
+    return true;
+}
+
+RACONFIG_INLINE std::vector<std::pair<const char*, std::string>> option_values(option_ops const *ops,
+                                                                               std::shared_ptr<void const> const *options,
+                                                                               size_t size)
+{
+    auto const names = describe_options(ops, options, size);
+    std::vector<std::pair<const char*, std::string>> res;
+    for (size_t i = 0; i < size; ++i)
+        res.emplace_back(names[i].name, ops[i].to_string(options[i].get()));
+    return res;
+}
+
+RACONFIG_INLINE void show_config(default_actions& actions, option_ops const *ops,
+                                 std::shared_ptr<void const> const *options, size_t size)
+{
+    actions.show_config_begin();
+    for (size_t i = 0; i < size; ++i)
+        ops[i].show(actions, options[i].get());
+    actions.show_config_end();
+}
+
+RACONFIG_INLINE void show_memory(default_actions& actions, option_ops const *ops,
+                                 std::shared_ptr<void const> const *options, size_t size)
+{
+    actions.show_memory_begin();
+    for (auto const& usage: memory_usage(ops, options, size))
+        actions.show_memory(usage.first, usage.second);
+    actions.show_memory_end();
+}
+
+RACONFIG_INLINE std::vector<std::pair<const char*, size_t>> memory_usage(option_ops const *ops,
+                                                                         std::shared_ptr<void const> const *options,
+                                                                         size_t size)
+{
+    auto const names = describe_options(ops, options, size);
+    std::vector<std::pair<const char*, size_t>> res;
+    for (size_t i = 0; i < size; ++i)
+        res.emplace_back(names[i].name, ops[i].memory_usage(options[i].get()));
+    return res;
+}
+
 RACONFIG_INLINE void throw_option_check_failed(const char *name, const char *value)
 {
     std::string what = "the argument ('";
@@ -116,6 +706,183 @@ RACONFIG_INLINE void throw_option_check_failed(const char *name, const char *val
     throw config_error{what};
 }
 
+// MurmurHash64A by Austin Appleby
+RACONFIG_INLINE uint64_t hash_bytes(const void *data, size_t size, uint64_t seed) noexcept
+{
+    uint64_t const m = 0xc6a4a7935bd1e995ULL;
+    int const r = 47;
+    uint64_t h = seed ^ (size * m);
+    auto p = static_cast<const unsigned char*>(data);
+    auto const end = p + size / 8 * 8;
+    for (; p != end; p += 8) {
+        uint64_t k;
+        std::memcpy(&k, p, sizeof k);
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+    switch (size & 7) {
+    case 7: h ^= uint64_t(p[6]) << 48; // fall through
+    case 6: h ^= uint64_t(p[5]) << 40; // fall through
+    case 5: h ^= uint64_t(p[4]) << 32; // fall through
+    case 4: h ^= uint64_t(p[3]) << 24; // fall through
+    case 3: h ^= uint64_t(p[2]) << 16; // fall through
+    case 2: h ^= uint64_t(p[1]) << 8;  // fall through
+    case 1: h ^= uint64_t(p[0]);
+            h *= m;
+    }
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+RACONFIG_INLINE uint64_t hash_args(int argc, const char* const argv[]) noexcept
+{
+    uint64_t h = hash_bytes(&argc, sizeof argc);
+    for (int i = 0; i < argc; ++i)
+        h = hash_bytes(argv[i], std::strlen(argv[i]) + 1, h);
+    return h;
+}
+
+// the file is hashed by fixed size blocks, fread() fills a whole block
+// unless the file ends
+RACONFIG_INLINE bool hash_file(const char *path, uint64_t& hash) noexcept
+{
+#ifdef __GLIBC__
+    std::FILE *file = std::fopen(path, "rbe");  // O_CLOEXEC
+#else
+    std::FILE *file = std::fopen(path, "rb");
+#endif
+    if (file == nullptr)
+        return false;
+    char buf[65536];
+    size_t size;
+    do {
+        size = std::fread(buf, 1, sizeof buf, file);
+        hash = hash_bytes(buf, size, hash);
+    } while (size == sizeof buf);
+    bool const ok = !std::ferror(file);
+    std::fclose(file);
+    return ok;
+}
+
+// CPU list in sysfs format, e.g. "0-3,8,10-11"
+RACONFIG_INLINE std::vector<int> parse_cpu_list(std::string const& list)
+{
+    std::vector<int> cpus;
+    const char *p = list.c_str();
+    while (*p >= '0' && *p <= '9') {
+        char *end;
+        long const first = std::strtol(p, &end, 10);
+        long last = first;
+        if (*end == '-')
+            last = std::strtol(end + 1, &end, 10);
+        for (long cpu = first; cpu <= last; ++cpu)
+            cpus.push_back(static_cast<int>(cpu));
+        p = *end == ',' ? end + 1 : end;
+    }
+    return cpus;
+}
+
+struct numa_topology
+{
+    numa_topology()
+    {
+#ifdef __linux__
+        std::ifstream online{"/sys/devices/system/node/online"};
+        std::string list;
+        std::getline(online, list);
+        for (int node: parse_cpu_list(list)) {
+            std::ifstream file{"/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"};
+            std::string cpulist;
+            std::getline(file, cpulist);
+            auto cpus = parse_cpu_list(cpulist);
+            if (cpus.empty())
+                continue;
+            for (int cpu: cpus) {
+                if (static_cast<size_t>(cpu) >= node_of_cpu.size())
+                    node_of_cpu.resize(cpu + 1, 0);
+                node_of_cpu[cpu] = node_cpus.size();
+            }
+            node_cpus.push_back(std::move(cpus));
+        }
+#endif
+        if (node_cpus.empty())
+            node_cpus.resize(1);
+    }
+
+    // nodes without CPUs are omitted, indexes are dense
+    std::vector<std::vector<int>> node_cpus;
+    std::vector<size_t> node_of_cpu;
+};
+
+RACONFIG_INLINE numa_topology const& numa()
+{
+    static numa_topology const topology;
+    return topology;
+}
+
+RACONFIG_INLINE size_t numa_nodes() noexcept
+{
+    try {
+        return numa().node_cpus.size();
+    } catch (...) {
+        return 1;
+    }
+}
+
+RACONFIG_INLINE size_t numa_node() noexcept
+{
+#ifdef __linux__
+    if (numa_nodes() < 2)
+        return 0;
+    int const cpu = sched_getcpu();
+    auto const& node_of_cpu = numa().node_of_cpu;
+    return cpu >= 0 && static_cast<size_t>(cpu) < node_of_cpu.size() ? node_of_cpu[cpu] : 0;
+#else
+    return 0;
+#endif
+}
+
+RACONFIG_INLINE void run_on_numa_nodes(std::function<void(size_t)> const& f) noexcept
+{
+    std::vector<std::thread> threads;
+    for (size_t node = 0; node < numa_nodes(); ++node) {
+        try {
+            threads.emplace_back([&f, node]() {
+#ifdef __linux__
+                auto const& cpus = numa().node_cpus[node];
+                if (numa_nodes() > 1) {
+                    cpu_set_t set;
+                    CPU_ZERO(&set);
+                    for (int cpu: cpus)
+                        if (cpu < CPU_SETSIZE)
+                            CPU_SET(cpu, &set);
+                    sched_setaffinity(0, sizeof set, &set);
+                }
+#endif
+                try {
+                    f(node);
+                } catch (...) {
+                }
+            });
+        } catch (...) {
+        }
+    }
+    for (auto& thread: threads)
+        thread.join();
+}
+
+RACONFIG_INLINE void throw_system_error(const char *what)
+{
+    std::string s = what;
+    s.append(": ").append(std::strerror(errno));
+    throw config_error{s};
+}
+
 } // namespace detail
 
 RACONFIG_INLINE void default_actions::help(boost::program_options::options_description const& desc)
@@ -153,6 +920,18 @@ RACONFIG_INLINE void default_actions::show_config_end()
     std::exit(EXIT_SUCCESS);
 }
 
+RACONFIG_INLINE void default_actions::show_memory_begin() {}
+
+RACONFIG_INLINE void default_actions::show_memory(const char* name, size_t bytes)
+{
+    std::cout << name << " = " << bytes << " bytes\n";
+}
+
+RACONFIG_INLINE void default_actions::show_memory_end()
+{
+    std::exit(EXIT_SUCCESS);
+}
+
 } // namespace raconfig
 
 #endif
@@ -0,0 +1,304 @@
+//
+// Copyright 2018 Rambler Digital Solutions
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef RACONFIG_ADMIN_HPP
+#define RACONFIG_ADMIN_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "raconfig.hpp"
+
+namespace raconfig
+{
+
+// Unix domain socket server for runtime updates of Config (Linux only).
+// Clients are served together by a dedicated thread with non-blocking
+// I/O, the protocol is line based:
+//
+//     name=value    add an update to the batch
+//     (empty line)  commit the batch by Config::update()
+//     get name      current value of an option
+//     dump          current values of all options
+//
+// A batch is committed as one generation by its empty line only, an
+// unterminated line and a pending batch are discarded when the client
+// closes the connection. Every command is answered with "ok[ result]"
+// or "error what", dump sends "name = value" lines before "ok". A line longer than 64 KiB closes the connection. Access
+// to the socket is controlled by permissions of its directory.
+template<class Config>
+class admin_server
+{
+public:
+    explicit admin_server(std::string path)
+        : path_{std::move(path)}
+    {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (path_.size() >= sizeof addr.sun_path)
+            throw config_error{"admin socket path is too long"};
+        std::memcpy(addr.sun_path, path_.c_str(), path_.size() + 1);
+        // a stale socket of a previous run is replaced, anything else is not
+        struct stat st;
+        if (lstat(path_.c_str(), &st) == 0) {
+            if (!S_ISSOCK(st.st_mode))
+                throw config_error{"'" + path_ + "' exists and is not a socket"};
+            unlink(path_.c_str());
+        }
+        listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listen_fd_ < 0)
+            detail::throw_system_error("socket");
+        if (bind(listen_fd_, reinterpret_cast<sockaddr const*>(&addr), sizeof addr) < 0 ||
+            listen(listen_fd_, 8) < 0) {
+            int const err = errno;
+            close(listen_fd_);
+            errno = err;
+            detail::throw_system_error("cannot listen on admin socket");
+        }
+        stop_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (stop_fd_ < 0) {
+            int const err = errno;
+            close(listen_fd_);
+            unlink(path_.c_str());
+            errno = err;
+            detail::throw_system_error("eventfd");
+        }
+        thread_ = std::thread{&admin_server::run, this};
+    }
+
+    admin_server(admin_server const&) = delete;
+    admin_server& operator = (admin_server const&) = delete;
+
+    ~admin_server()
+    {
+        uint64_t one = 1;
+        while (write(stop_fd_, &one, sizeof one) < 0 && errno == EINTR);
+        thread_.join();
+        close(stop_fd_);
+        close(listen_fd_);
+        unlink(path_.c_str());
+    }
+
+private:
+    static constexpr size_t max_line = 65536;
+    // a client not reading replies isn't read either
+    static constexpr size_t max_output = 1 << 20;
+    static constexpr size_t max_clients = 16;
+
+    struct client
+    {
+        int fd;
+        std::string in;
+        std::string out;
+        std::vector<std::pair<std::string, std::string>> batch;
+        // nothing more is read, the connection is closed once out is sent
+        bool closing;
+    };
+
+    void run()
+    {
+        std::vector<client> clients;
+        std::vector<pollfd> fds;
+        for (;;) {
+            fds.clear();
+            fds.push_back({listen_fd_, POLLIN, 0});
+            fds.push_back({stop_fd_, POLLIN, 0});
+            for (auto const& c: clients) {
+                short events = 0;
+                if (!c.closing && c.out.size() < max_output)
+                    events |= POLLIN;
+                if (!c.out.empty())
+                    events |= POLLOUT;
+                fds.push_back({c.fd, events, 0});
+            }
+            if (poll(fds.data(), fds.size(), -1) < 0) {
+                if (errno == EINTR)
+                    continue;
+                break;
+            }
+            if (fds[1].revents != 0)
+                break;
+            for (size_t i = 0; i < clients.size(); ++i) {
+                if (fds[i + 2].revents == 0 || serve(clients[i]))
+                    continue;
+                close(clients[i].fd);
+                clients[i].fd = -1;
+            }
+            clients.erase(std::remove_if(clients.begin(), clients.end(),
+                                         [](client const& c) { return c.fd < 0; }), clients.end());
+            if (fds[0].revents != 0)
+                accept_clients(clients);
+        }
+        for (auto const& c: clients)
+            close(c.fd);
+    }
+
+    void accept_clients(std::vector<client>& clients)
+    {
+        for (;;) {
+            int const fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0 && errno == EINTR)
+                continue;
+            if (fd < 0)
+                return;
+            if (clients.size() == max_clients) {
+                static char const busy[] = "error too many clients\n";
+                (void)send(fd, busy, sizeof busy - 1, MSG_NOSIGNAL);
+                close(fd);
+                continue;
+            }
+            clients.push_back(client{fd, {}, {}, {}, false});
+        }
+    }
+
+    // false if the connection should be closed
+    bool serve(client& c)
+    {
+        char buf[4096];
+        while (!c.closing && c.out.size() < max_output) {
+            ssize_t const n = recv(c.fd, buf, sizeof buf, 0);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+            if (n < 0)
+                return false;
+            if (n == 0) {
+                // a batch without its empty line may be cut off, drop it
+                c.in.clear();
+                c.batch.clear();
+                c.closing = true;
+                break;
+            }
+            c.in.append(buf, n);
+            size_t first = 0;
+            for (size_t eol; !c.closing && (eol = c.in.find('\n', first)) != std::string::npos; first = eol + 1) {
+                size_t end = eol;
+                if (end != first && c.in[end - 1] == '\r')
+                    --end;
+                if (end - first > max_line)
+                    too_long(c);
+                else
+                    execute(c, c.in.substr(first, end - first));
+            }
+            c.in.erase(0, first);
+            if (c.in.size() > max_line)
+                too_long(c);
+        }
+        return flush(c) && !(c.closing && c.out.empty());
+    }
+
+    void too_long(client& c)
+    {
+        reply(c, "error line is too long");
+        c.in.clear();
+        c.batch.clear();
+        c.closing = true;
+    }
+
+    void execute(client& c, std::string const& line)
+    {
+        if (line.empty() && c.batch.empty())
+            return reply(c, "ok " + std::to_string(Config::instance().generation()));
+        if (line.empty())
+            return commit(c);
+        try {
+            if (line == "dump") {
+                std::string out;
+                for (auto const& v: Config::instance().values())
+                    out.append(v.first).append(" = ").append(v.second).append("\n");
+                return reply(c, out + "ok");
+            }
+            if (line.compare(0, 4, "get ") == 0) {
+                std::string value;
+                if (!Config::instance().value(line.substr(4), value))
+                    return reply(c, "error unrecognised option '" + line.substr(4) + "'");
+                return reply(c, "ok " + value);
+            }
+        } catch (std::exception const& e) {
+            // lazy option failed to materialize
+            return reply(c, std::string{"error "} + e.what());
+        }
+        size_t const eq = line.find('=');
+        if (eq == std::string::npos || eq == 0)
+            return reply(c, "error expected name=value, get name or dump");
+        c.batch.emplace_back(line.substr(0, eq), line.substr(eq + 1));
+    }
+
+    void commit(client& c)
+    {
+        std::string res;
+        try {
+            res = "ok " + std::to_string(Config::instance().update(c.batch));
+        } catch (std::exception const& e) {
+            res = std::string{"error "} + e.what();
+        }
+        c.batch.clear();
+        reply(c, res);
+    }
+
+    static void reply(client& c, std::string const& s)
+    {
+        c.out.append(s).append("\n");
+    }
+
+    // false if the client is gone
+    static bool flush(client& c)
+    {
+        size_t sent = 0;
+        while (sent != c.out.size()) {
+            ssize_t const n = send(c.fd, c.out.data() + sent, c.out.size() - sent, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+            if (n < 0)
+                return false;
+            sent += n;
+        }
+        c.out.erase(0, sent);
+        return true;
+    }
+
+    std::string path_;
+    int listen_fd_;
+    int stop_fd_;
+    std::thread thread_;
+};
+
+template<class Config>
+constexpr size_t admin_server<Config>::max_line;
+
+template<class Config>
+constexpr size_t admin_server<Config>::max_output;
+
+template<class Config>
+constexpr size_t admin_server<Config>::max_clients;
+
+} // namespace raconfig
+
+#endif
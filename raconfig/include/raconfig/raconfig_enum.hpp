@@ -0,0 +1,263 @@
+//
+// Copyright 2018 Rambler Digital Solutions
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef RACONFIG_ENUM_HPP
+#define RACONFIG_ENUM_HPP
+
+#include <boost/preprocessor/seq/enum.hpp>
+#include <boost/preprocessor/seq/for_each.hpp>
+#include <boost/preprocessor/seq/transform.hpp>
+#include <boost/preprocessor/stringize.hpp>
+#include <boost/preprocessor/variadic/to_seq.hpp>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "raconfig.hpp"
+
+namespace raconfig
+{
+namespace detail
+{
+
+// names of enumerators 0..size-1
+struct enum_names
+{
+    const char* const* names;
+    size_t size;
+};
+
+template<class T>
+auto has_enum_names(int) -> decltype(raconfig_enum_names(static_cast<T*>(nullptr)), std::true_type{});
+
+template<class T>
+std::false_type has_enum_names(...);
+
+// enums declared by RACONFIG_ENUM
+template<class T>
+using is_named_enum = decltype(has_enum_names<T>(0));
+
+// enumerator values must be their indices in the name table
+constexpr bool has_initializer(const char *name) noexcept
+{
+    return *name != '\0' && (*name == '=' || has_initializer(name + 1));
+}
+
+inline char ascii_lower(char c) noexcept
+{
+    return c >= 'A' && c <= 'Z' ? char(c - 'A' + 'a') : c;
+}
+
+// Case insensitive perfect hash of enumerator names: the seed and the
+// table size are chosen once so that every name has its own slot, a
+// lookup hashes the input and compares it with a single candidate.
+class enum_index
+{
+public:
+    explicit enum_index(enum_names names)
+        : names_{names}
+    {
+        // names equal ignoring case would never get their own slots
+        for (size_t i = 0; i < names.size; ++i)
+            for (size_t j = 0; j < i; ++j)
+                if (equal(names.names[j], names.names[i]))
+                    throw config_error{std::string{"enumerators '"} + names.names[j] +
+                        "' and '" + names.names[i] + "' differ only in case"};
+        for (size_t size = 2; size <= max_size; size *= 2) {
+            if (size < names.size * 2)
+                continue;
+            for (seed_ = 0; seed_ < 64; ++seed_)
+                if (build(size))
+                    return;
+        }
+        throw config_error{"cannot build enumerator name index"};
+    }
+
+    bool find(std::string const& s, size_t& index) const noexcept
+    {
+        size_t const slot = slots_[hash(s.data(), s.size(), seed_) & (slots_.size() - 1)];
+        if (slot == 0 || !equal(names_.names[slot - 1], s))
+            return false;
+        index = slot - 1;
+        return true;
+    }
+
+    enum_names const& names() const noexcept { return names_; }
+
+private:
+    static uint32_t hash(const char *s, size_t size, uint32_t seed) noexcept
+    {
+        uint32_t h = 2166136261u ^ (seed * 16777619u);
+        for (size_t i = 0; i < size; ++i)
+            h = (h ^ static_cast<unsigned char>(ascii_lower(s[i]))) * 16777619u;
+        return h ^ (h >> 15);
+    }
+
+    static bool equal(const char *name, const char *s) noexcept
+    {
+        for (; *s != '\0'; ++s)
+            if (*name == '\0' || ascii_lower(*name++) != ascii_lower(*s))
+                return false;
+        return *name == '\0';
+    }
+
+    static bool equal(const char *name, std::string const& s) noexcept
+    {
+        for (char c: s)
+            if (*name == '\0' || ascii_lower(*name++) != ascii_lower(c))
+                return false;
+        return *name == '\0';
+    }
+
+    bool build(size_t size)
+    {
+        slots_.assign(size, 0);
+        for (size_t i = 0; i < names_.size; ++i) {
+            auto& slot = slots_[hash(names_.names[i], std::strlen(names_.names[i]), seed_) & (size - 1)];
+            if (slot != 0)
+                return false;
+            slot = i + 1;
+        }
+        return true;
+    }
+
+    static constexpr size_t max_size = size_t{1} << 20;
+
+    enum_names names_;
+    uint32_t seed_ = 0;
+    // index + 1 of the name, 0 for empty slots
+    std::vector<size_t> slots_;
+};
+
+template<class T>
+enum_index const& get_enum_index()
+{
+    static enum_index const index{raconfig_enum_names(static_cast<T*>(nullptr))};
+    return index;
+}
+
+template<class T>
+T parse_enum(std::string const& s)
+{
+    size_t index;
+    if (!get_enum_index<T>().find(s, index))
+        boost::throw_exception(boost::program_options::invalid_option_value(s));
+    return static_cast<T>(index);
+}
+
+template<class T>
+struct type_proxy<T, typename std::enable_if<is_named_enum<T>::value>::type>
+{
+    static std::string to_string(T const& v)
+    {
+        auto const& names = get_enum_index<T>().names();
+        auto const i = static_cast<size_t>(v);
+        return i < names.size ? names.names[i] : std::to_string(i);
+    }
+
+    static void show_option(default_actions& actions, const char *name, T const& v)
+    {
+        return actions.show_config(name, to_string(v));
+    }
+
+    static size_t heap_usage(T const&) noexcept { return 0; }
+};
+
+// Parses a single token, also used by the validate() overload which
+// RACONFIG_ENUM declares for boost containers of the enum
+template<class T>
+void validate_enum(boost::any& value_store, std::vector<std::string> const& tokens)
+{
+    namespace po = boost::program_options;
+    po::validators::check_first_occurrence(value_store);
+    value_store = parse_enum<T>(po::validators::get_single_string(tokens));
+}
+
+// Parsed by the name table without iostreams, --help shows allowed
+// values. Doesn't derive from typed_value which requires operator >>.
+template<class T>
+class enum_value: public boost::program_options::value_semantic_codecvt_helper<char>
+{
+public:
+    std::string name() const override
+    {
+        auto const& names = get_enum_index<T>().names();
+        std::string s;
+        for (size_t i = 0; i < names.size; ++i)
+            s.append(i == 0 ? "" : "|").append(names.names[i]);
+        return s;
+    }
+
+    unsigned min_tokens() const override { return 1; }
+    unsigned max_tokens() const override { return 1; }
+    bool is_composing() const override { return false; }
+    bool is_required() const override { return false; }
+    bool apply_default(boost::any&) const override { return false; }
+    void notify(boost::any const&) const override {}
+
+protected:
+    void xparse(boost::any& value_store, std::vector<std::string> const& tokens) const override
+    {
+        validate_enum<T>(value_store, tokens);
+    }
+};
+
+template<class T>
+struct list_item<T, typename std::enable_if<is_named_enum<T>::value>::type>: std::true_type
+{
+    static T parse(std::string const& token)
+    {
+        return parse_enum<T>(token);
+    }
+};
+
+template<class T>
+struct backend_semantic<T, typename std::enable_if<is_named_enum<T>::value>::type>
+{
+    static boost::program_options::value_semantic* make()
+    {
+        return new enum_value<T>;
+    }
+};
+
+} // namespace detail
+} // namespace raconfig
+
+#define RACONFIG_DETAIL_ENUM_NAME(s, data, elem) BOOST_PP_STRINGIZE(elem)
+
+#define RACONFIG_DETAIL_ENUM_CHECK(r, data, elem) \
+    static_assert(!raconfig::detail::has_initializer(BOOST_PP_STRINGIZE(elem)), \
+        "RACONFIG_ENUM enumerators can't have initializers: " BOOST_PP_STRINGIZE(elem));
+
+// Declares enum class with a name table at namespace scope. Values are
+// parsed case insensitively and printed by their names. Enumerators are
+// numbered from 0 and can't have initializers.
+#define RACONFIG_ENUM(name, ...) \
+    enum class name { __VA_ARGS__ }; \
+    BOOST_PP_SEQ_FOR_EACH(RACONFIG_DETAIL_ENUM_CHECK, _, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__)) \
+    inline raconfig::detail::enum_names raconfig_enum_names(name*) noexcept \
+    { \
+        static constexpr const char* const names[] = { \
+            BOOST_PP_SEQ_ENUM(BOOST_PP_SEQ_TRANSFORM(RACONFIG_DETAIL_ENUM_NAME, _, \
+                    BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))) \
+        }; \
+        return {names, sizeof(names) / sizeof(names[0])}; \
+    } \
+    inline void validate(boost::any& value_store, std::vector<std::string> const& tokens, name*, int) \
+    { \
+        raconfig::detail::validate_enum<name>(value_store, tokens); \
+    }
+
+#endif
@@ -0,0 +1,245 @@
+//
+// Copyright 2018 Rambler Digital Solutions
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef RACONFIG_MAPPED_LIST_HPP
+#define RACONFIG_MAPPED_LIST_HPP
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "raconfig.hpp"
+
+#if __cplusplus >= 201703L
+#include <string_view>
+#else
+#include <boost/utility/string_ref.hpp>
+#endif
+
+namespace raconfig
+{
+
+#if __cplusplus >= 201703L
+using string_view = std::string_view;
+#else
+using string_view = boost::string_ref;
+#endif
+
+// Read-only list of lines of a memory mapped file. Items point directly
+// into the mapping, empty lines are skipped. Copies share the mapping.
+// The mapping is private but not a copy: the file must be replaced (e.g.
+// renamed over) rather than truncated in place, reading a truncated part
+// of the mapping raises SIGBUS.
+class mapped_list
+{
+public:
+    using value_type = string_view;
+    using size_type = size_t;
+    using const_iterator = std::vector<string_view>::const_iterator;
+    using iterator = const_iterator;
+
+    mapped_list() = default;
+
+    explicit mapped_list(std::string path)
+        : path_{std::move(path)}
+    {
+        if (path_.empty())
+            return;
+        int fd = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            detail::throw_system_error(("cannot open '" + path_ + "'").c_str());
+        struct stat st;
+        if (fstat(fd, &st) < 0) {
+            int const err = errno;
+            close(fd);
+            errno = err;
+            detail::throw_system_error(("cannot stat '" + path_ + "'").c_str());
+        }
+        identity_ = file_identity{st};
+        auto const size = static_cast<size_t>(st.st_size);
+        void *addr = size == 0 ? nullptr
+                : mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        int const err = errno;
+        close(fd);
+        if (addr == MAP_FAILED) {
+            errno = err;
+            detail::throw_system_error(("cannot map '" + path_ + "'").c_str());
+        }
+        if (addr == nullptr)
+            return;
+        mapping_ = std::make_shared<mapping>(addr, size);
+        index(static_cast<const char*>(addr), size);
+    }
+
+    const_iterator begin() const noexcept { return items_.begin(); }
+    const_iterator end() const noexcept { return items_.end(); }
+    size_type size() const noexcept { return items_.size(); }
+    bool empty() const noexcept { return items_.empty(); }
+    string_view operator [](size_type i) const noexcept { return items_[i]; }
+
+    // path to the list file
+    std::string const& path() const noexcept { return path_; }
+
+    // false if the path now refers to another file or the file has been
+    // modified since it was mapped
+    bool unchanged() const noexcept
+    {
+        if (path_.empty())
+            return true;
+        struct stat st;
+        return stat(path_.c_str(), &st) == 0 && file_identity{st} == identity_;
+    }
+
+    // size of the index and of the mapped file
+    size_t memory_usage() const noexcept
+    {
+        return items_.capacity() * sizeof(string_view) + detail::heap_usage(path_) +
+            (mapping_ ? mapping_->size : 0);
+    }
+
+private:
+    struct file_identity
+    {
+        file_identity() = default;
+
+        explicit file_identity(struct stat const& st) noexcept
+            : dev{st.st_dev}
+            , ino{st.st_ino}
+            , size{st.st_size}
+            , mtime{st.st_mtim}
+        {}
+
+        bool operator == (file_identity const& other) const noexcept
+        {
+            return dev == other.dev && ino == other.ino && size == other.size &&
+                mtime.tv_sec == other.mtime.tv_sec && mtime.tv_nsec == other.mtime.tv_nsec;
+        }
+
+        dev_t dev = 0;
+        ino_t ino = 0;
+        off_t size = 0;
+        timespec mtime{};
+    };
+
+    struct mapping
+    {
+        mapping(void *addr, size_t size)
+            : addr{addr}
+            , size{size}
+        {}
+
+        mapping(mapping const&) = delete;
+        mapping& operator = (mapping const&) = delete;
+
+        ~mapping()
+        {
+            munmap(addr, size);
+        }
+
+        void *addr;
+        size_t size;
+    };
+
+    void index(const char *first, size_t size)
+    {
+        const char *last = first + size;
+        while (first != last) {
+            auto eol = static_cast<const char*>(std::memchr(first, '\n', last - first));
+            if (eol == nullptr)
+                eol = last;
+            auto end = eol;
+            if (end != first && end[-1] == '\r')
+                --end;
+            if (end != first)
+                items_.emplace_back(first, end - first);
+            first = eol == last ? last : eol + 1;
+        }
+    }
+
+    std::string path_;
+    file_identity identity_;
+    std::shared_ptr<mapping const> mapping_;
+    std::vector<string_view> items_;
+};
+
+namespace detail
+{
+
+template<>
+struct type_proxy<mapped_list>
+{
+    static std::string to_string(mapped_list const& v)
+    {
+        return v.path();
+    }
+
+    static void show_option(default_actions& actions, const char *name, mapped_list const& v)
+    {
+        return actions.show_config(name, to_string(v));
+    }
+
+    static size_t heap_usage(mapped_list const& v) noexcept
+    {
+        return v.memory_usage();
+    }
+};
+
+// Config value of the option is a path to the list file, the file is
+// mapped and indexed once the value is parsed. The file may change while
+// the path is the same, so the value is shared between snapshots only
+// while the file has the same device, inode, size and modification time.
+template<>
+class option_value<mapped_list>
+    : public option_value_backend<std::string>
+    , public external_option
+{
+public:
+    option_value(const char *path)
+        : option_value_backend<std::string>{path}
+    {}
+
+    option_value(std::string path)
+        : option_value_backend<std::string>{std::move(path)}
+    {}
+
+    mapped_list const& operator ()(get_user_type) const noexcept { return value_; }
+    mapped_list const& operator ()(get_unchecked) const noexcept { return value_; }
+
+    size_t operator ()(get_heap_usage) const noexcept
+    {
+        return detail::heap_usage(value_) + detail::heap_usage(**this);
+    }
+
+    void operator ()(transform_backend)
+    {
+        value_ = mapped_list{**this};
+    }
+
+    bool operator ()(input_unchanged) const noexcept
+    {
+        return value_.unchanged();
+    }
+
+private:
+    mapped_list value_;
+};
+
+} // namespace detail
+} // namespace raconfig
+
+#endif
@@ -0,0 +1,77 @@
+//
+// Copyright 2018 Rambler Digital Solutions
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef RACONFIG_NOTIFIER_HPP
+#define RACONFIG_NOTIFIER_HPP
+
+#include <cerrno>
+#include <cstdint>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include "raconfig.hpp"
+
+namespace raconfig
+{
+
+// Eventfd which becomes readable whenever Config commits a new generation
+// (Linux only). Every event loop should own its notifier: register fd()
+// for reading and call consume() when it is ready, then pick up new
+// values with Config::get() in the loop's own thread.
+template<class Config>
+class change_notifier: public commit_listener
+{
+public:
+    change_notifier()
+        : fd_{eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)}
+    {
+        if (fd_ < 0)
+            detail::throw_system_error("eventfd");
+        Config::instance().add_listener(this);
+    }
+
+    change_notifier(change_notifier const&) = delete;
+    change_notifier& operator = (change_notifier const&) = delete;
+
+    ~change_notifier()
+    {
+        Config::instance().remove_listener(this);
+        close(fd_);
+    }
+
+    int fd() const noexcept { return fd_; }
+
+    // make the descriptor not readable until the next commit and return
+    // the current generation
+    unsigned long consume() noexcept
+    {
+        uint64_t count;
+        while (read(fd_, &count, sizeof count) < 0 && errno == EINTR);
+        return Config::instance().generation();
+    }
+
+private:
+    void committed(unsigned long) noexcept override
+    {
+        uint64_t one = 1;
+        while (write(fd_, &one, sizeof one) < 0 && errno == EINTR);
+    }
+
+    int fd_;
+};
+
+} // namespace raconfig
+
+#endif
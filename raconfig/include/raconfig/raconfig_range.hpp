@@ -34,6 +34,9 @@ struct default_actions
     virtual void show_config(const char* name, std::string value);
     virtual void show_config(const char* name, std::vector<std::string> value);
     virtual void show_config_end();
+    virtual void show_memory_begin();
+    virtual void show_memory(const char* name, size_t bytes);
+    virtual void show_memory_end();
 };
 
 namespace detail
@@ -45,6 +48,9 @@ class option_value;
 template<class T>
 std::string to_string(T const& v);
 
+template<class T>
+size_t heap_usage(T const& v);
+
 template<class Iter>
 std::string to_string(Iter first, Iter last)
 {
@@ -80,6 +86,15 @@ struct type_proxy_range
     {
         return detail::show_option(actions, name, std::begin(v), std::end(v));
     }
+
+    // heap memory owned by elements, container nodes are not included
+    static size_t elements_heap_usage(T const& v)
+    {
+        size_t bytes = 0;
+        for (auto const& x: v)
+            bytes += detail::heap_usage(x);
+        return bytes;
+    }
 };
 
 template<class T>
@@ -105,7 +120,10 @@ private:
 };
 
 struct get_user_type{};
+struct get_unchecked{};
+struct get_heap_usage{};
 struct transform_backend{};
+struct set_value{};
 
 template<class T, class U>
 class convertible_option_value: public option_value_backend<U>
@@ -122,6 +140,13 @@ public:
     {}
 
     T const& operator ()(get_user_type) const noexcept { return value_; }
+    T const& operator ()(get_unchecked) const noexcept { return value_; }
+
+    // both staging and final containers are kept alive
+    size_t operator ()(get_heap_usage) const noexcept
+    {
+        return detail::heap_usage(value_) + detail::heap_usage(**this);
+    }
 
     void operator ()(transform_backend)
     {
@@ -0,0 +1,160 @@
+//
+// Copyright 2018 Rambler Digital Solutions
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef RACONFIG_REGEX_HPP
+#define RACONFIG_REGEX_HPP
+
+#include <memory>
+#include <mutex>
+#include <regex>
+#include "raconfig.hpp"
+
+namespace raconfig
+{
+
+// Regular expression compiled once on first use, the option check uses
+// it when the option is parsed. Copies share the compiled automaton,
+// which may be used by many threads.
+class regex
+{
+public:
+    regex() = default;
+
+    explicit regex(std::string pattern)
+        : state_{std::make_shared<state>(std::move(pattern))}
+    {}
+
+    // source pattern
+    std::string const& pattern() const noexcept
+    {
+        static std::string const empty;
+        return state_ ? state_->pattern : empty;
+    }
+
+    // false if the pattern can't be compiled
+    bool valid() const noexcept { return compiled() != nullptr; }
+
+    // an invalid pattern is an empty expression which matches nothing
+    std::regex const& get() const noexcept
+    {
+        static std::regex const empty;
+        auto const re = compiled();
+        return re ? *re : empty;
+    }
+
+    operator std::regex const& () const noexcept { return get(); }
+
+    bool match(std::string const& s) const { return valid() && std::regex_match(s, get()); }
+    bool search(std::string const& s) const { return valid() && std::regex_search(s, get()); }
+
+private:
+    struct state
+    {
+        explicit state(std::string pattern)
+            : pattern{std::move(pattern)}
+        {}
+
+        std::string const pattern;
+        std::once_flag once;
+        std::unique_ptr<std::regex const> re;
+    };
+
+    std::regex const* compiled() const noexcept
+    {
+        if (!state_)
+            return nullptr;
+        auto& s = *state_;
+        std::call_once(s.once, [&s]() {
+            try {
+                s.re.reset(new std::regex{s.pattern, std::regex::ECMAScript | std::regex::optimize});
+            } catch (std::regex_error const&) {
+                // reported by the option check
+            }
+        });
+        return s.re.get();
+    }
+
+    std::shared_ptr<state> state_;
+};
+
+namespace detail
+{
+
+template<>
+struct type_proxy<regex>
+{
+    static std::string to_string(regex const& v)
+    {
+        return v.pattern();
+    }
+
+    static void show_option(default_actions& actions, const char *name, regex const& v)
+    {
+        return actions.show_config(name, to_string(v));
+    }
+
+    // size of the automaton is unknown
+    static size_t heap_usage(regex const& v) noexcept
+    {
+        return detail::heap_usage(v.pattern()) + (v.valid() ? sizeof(std::regex) : 0);
+    }
+};
+
+template<>
+struct value_validity<regex>
+{
+    static bool valid(regex const& v) noexcept { return v.valid(); }
+};
+
+// Config value of the option is the pattern, it is compiled by the
+// option check once the value is parsed, which fails if it can't be
+// compiled. The default value of a config which isn't parsed yet is
+// compiled on first use.
+template<>
+class option_value<regex>: public option_value_backend<std::string>
+{
+public:
+    option_value(const char *pattern)
+        : option_value_backend<std::string>{pattern}
+        , value_{pattern}
+    {}
+
+    option_value(std::string pattern)
+        : option_value_backend<std::string>{pattern}
+        , value_{std::move(pattern)}
+    {}
+
+    regex const& operator ()(get_user_type) const noexcept { return value_; }
+    regex const& operator ()(get_unchecked) const noexcept { return value_; }
+
+    size_t operator ()(get_heap_usage) const noexcept
+    {
+        return detail::heap_usage(value_) + detail::heap_usage(**this);
+    }
+
+    void operator ()(transform_backend)
+    {
+        value_ = regex{**this};
+    }
+
+private:
+    regex value_;
+};
+
+} // namespace detail
+} // namespace raconfig
+
+#endif
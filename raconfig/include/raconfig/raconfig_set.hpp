@@ -25,10 +25,20 @@ namespace raconfig
 namespace detail
 {
 
+// red-black tree node: color, parent, left, right and value
+template<class T>
+constexpr size_t tree_node_size() { return 4 * sizeof(void*) + sizeof(T); }
+
 template<class T, class Compare, class Allocator>
 struct type_proxy<std::set<T, Compare, Allocator>>
     : type_proxy_range<std::set<T, Compare, Allocator>>
-{};
+{
+    static size_t heap_usage(std::set<T, Compare, Allocator> const& v)
+    {
+        return v.size() * detail::tree_node_size<T>() +
+            type_proxy_range<std::set<T, Compare, Allocator>>::elements_heap_usage(v);
+    }
+};
 
 template<class T, class Compare, class Allocator>
 class option_value<std::set<T, Compare, Allocator>>
@@ -53,7 +63,13 @@ public:
 template<class T, class Compare, class Allocator>
 struct type_proxy<std::multiset<T, Compare, Allocator>>
     : type_proxy_range<std::multiset<T, Compare, Allocator>>
-{};
+{
+    static size_t heap_usage(std::multiset<T, Compare, Allocator> const& v)
+    {
+        return v.size() * detail::tree_node_size<T>() +
+            type_proxy_range<std::multiset<T, Compare, Allocator>>::elements_heap_usage(v);
+    }
+};
 
 template<class T, class Compare, class Allocator>
 class option_value<std::multiset<T, Compare, Allocator>>
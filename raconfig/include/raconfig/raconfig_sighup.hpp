@@ -0,0 +1,122 @@
+//
+// Copyright 2018 Rambler Digital Solutions
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef RACONFIG_SIGHUP_HPP
+#define RACONFIG_SIGHUP_HPP
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+#include "raconfig.hpp"
+
+namespace raconfig
+{
+
+// Reloads Config on SIGHUP. SIGHUP is blocked in the constructing thread
+// (and so in all threads created by it afterwards) and consumed through
+// a signalfd by a dedicated thread, which calls Config::reload(). Signals
+// arriving during a reload are merged into a single follow-up reload.
+// Construct it in the main thread before any other thread is spawned.
+template<class Config>
+class sighup_reloader
+{
+public:
+    explicit sighup_reloader(void (*on_error)(config_error const&) = nullptr)
+        : on_error_{on_error}
+    {
+        sigset_t mask;
+        sigemptyset(&mask);
+        sigaddset(&mask, SIGHUP);
+        if ((errno = pthread_sigmask(SIG_BLOCK, &mask, nullptr)) != 0)
+            detail::throw_system_error("pthread_sigmask");
+        signal_fd_ = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+        if (signal_fd_ < 0)
+            detail::throw_system_error("signalfd");
+        stop_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (stop_fd_ < 0) {
+            int const err = errno;
+            close(signal_fd_);
+            errno = err;
+            detail::throw_system_error("eventfd");
+        }
+        thread_ = std::thread{&sighup_reloader::run, this};
+    }
+
+    sighup_reloader(sighup_reloader const&) = delete;
+    sighup_reloader& operator = (sighup_reloader const&) = delete;
+
+    ~sighup_reloader()
+    {
+        uint64_t one = 1;
+        while (write(stop_fd_, &one, sizeof one) < 0 && errno == EINTR);
+        thread_.join();
+        close(stop_fd_);
+        close(signal_fd_);
+    }
+
+private:
+    void run()
+    {
+        pollfd fds[2] = {{signal_fd_, POLLIN, 0}, {stop_fd_, POLLIN, 0}};
+        for (;;) {
+            if (poll(fds, 2, -1) < 0) {
+                if (errno == EINTR)
+                    continue;
+                // no more reloads, report it rather than spin
+                if (on_error_)
+                    on_error_(config_error{std::string{"cannot wait for SIGHUP: "} + std::strerror(errno)});
+                return;
+            }
+            if (fds[1].revents != 0)
+                return;
+            if (fds[0].revents == 0 || !drain())
+                continue;
+            try {
+                Config::instance().reload();
+            } catch (config_error const& e) {
+                if (on_error_)
+                    on_error_(e);
+            }
+        }
+    }
+
+    // consume all pending SIGHUPs at once
+    bool drain()
+    {
+        signalfd_siginfo info[8];
+        bool received = false;
+        while (read(signal_fd_, info, sizeof info) > 0)
+            received = true;
+        return received;
+    }
+
+    void (*on_error_)(config_error const&);
+    int signal_fd_;
+    int stop_fd_;
+    std::thread thread_;
+};
+
+} // namespace raconfig
+
+#endif
@@ -0,0 +1,186 @@
+//
+// Copyright 2018 Rambler Digital Solutions
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef RACONFIG_TUNABLE_HPP
+#define RACONFIG_TUNABLE_HPP
+
+#include <cstdint>
+#include <cstring>
+#include "raconfig.hpp"
+
+namespace raconfig
+{
+namespace detail
+{
+
+// Values fitting into a machine word are stored in a single atomic.
+template<class T, bool = (sizeof(T) <= sizeof(uint64_t))>
+class atomic_cell
+{
+public:
+    explicit atomic_cell(T const& value) noexcept
+    {
+        store(value);
+    }
+
+    T load() const noexcept
+    {
+        uint64_t const w = word_.load(std::memory_order_acquire);
+        T value;
+        std::memcpy(&value, &w, sizeof value);
+        return value;
+    }
+
+    void store(T const& value) noexcept
+    {
+        uint64_t w = 0;
+        std::memcpy(&w, &value, sizeof value);
+        word_.store(w, std::memory_order_release);
+    }
+
+private:
+    std::atomic<uint64_t> word_;
+};
+
+// Larger values are protected by a seqlock, writers must be serialized.
+template<class T>
+class atomic_cell<T, false>
+{
+public:
+    explicit atomic_cell(T const& value) noexcept
+    {
+        store(value);
+    }
+
+    T load() const noexcept
+    {
+        uint64_t buf[words];
+        unsigned seq;
+        do {
+            seq = seq_.load(std::memory_order_acquire);
+            // acquire loads keep the sequence recheck after the data
+            for (size_t i = 0; i < words; ++i)
+                buf[i] = data_[i].load(std::memory_order_acquire);
+        } while ((seq & 1) != 0 || seq != seq_.load(std::memory_order_relaxed));
+        T value;
+        std::memcpy(&value, buf, sizeof value);
+        return value;
+    }
+
+    void store(T const& value) noexcept
+    {
+        uint64_t buf[words] = {};
+        std::memcpy(buf, &value, sizeof value);
+        unsigned const seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);
+        // release stores publish the odd sequence before the data
+        for (size_t i = 0; i < words; ++i)
+            data_[i].store(buf[i], std::memory_order_release);
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+private:
+    static constexpr size_t words = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<unsigned> seq_{0};
+    std::atomic<uint64_t> data_[words];
+};
+
+} // namespace detail
+
+// Trivially copyable option value which may be changed in place at
+// runtime by config::set() without publishing a new snapshot.
+template<class T>
+class tunable
+{
+#if !defined(__GNUC__) || defined(__clang__) || __GNUC__ >= 5
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Tunable type should be trivially copyable");
+#endif
+public:
+    tunable(T const& value = T{}) noexcept
+        : cell_{value}
+    {}
+
+    tunable(tunable const& other) noexcept
+        : cell_{other.load()}
+    {}
+
+    tunable& operator = (tunable const& other) noexcept
+    {
+        store(other.load());
+        return *this;
+    }
+
+    T load() const noexcept { return cell_.load(); }
+    operator T() const noexcept { return load(); }
+    void store(T const& value) noexcept { cell_.store(value); }
+
+private:
+    detail::atomic_cell<T> cell_;
+};
+
+namespace detail
+{
+
+template<class T>
+struct type_proxy<tunable<T>>
+{
+    static std::string to_string(tunable<T> const& v)
+    {
+        return detail::to_string(v.load());
+    }
+
+    static void show_option(default_actions& actions, const char *name, tunable<T> const& v)
+    {
+        return type_proxy<T>::show_option(actions, name, v.load());
+    }
+
+    static size_t heap_usage(tunable<T> const&) noexcept { return 0; }
+};
+
+template<class T>
+class option_value<tunable<T>>: public option_value_backend<T>, public unshareable_option
+{
+public:
+    option_value(T const& value)
+        : option_value_backend<T>{value}
+        , value_{value}
+    {}
+
+    tunable<T> const& operator ()(get_user_type) const noexcept { return value_; }
+    tunable<T> const& operator ()(get_unchecked) const noexcept { return value_; }
+    size_t operator ()(get_heap_usage) const noexcept { return 0; }
+
+    void operator ()(transform_backend)
+    {
+        value_.store(**this);
+    }
+
+    // value of a published snapshot is changed in place
+    void operator ()(set_value, tunable<T> const& value) const noexcept
+    {
+        value_.store(value.load());
+    }
+
+private:
+    mutable tunable<T> value_;
+};
+
+} // namespace detail
+} // namespace raconfig
+
+#endif
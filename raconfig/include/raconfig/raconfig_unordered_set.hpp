@@ -25,10 +25,20 @@ namespace raconfig
 namespace detail
 {
 
+// hash table node: next, cached hash and value
+template<class T>
+constexpr size_t hash_node_size() { return 2 * sizeof(void*) + sizeof(T); }
+
 template<class T, class Hash, class Equal, class Allocator>
 struct type_proxy<std::unordered_set<T, Hash, Equal, Allocator>>
     : type_proxy_range<std::unordered_set<T, Hash, Equal, Allocator>>
-{};
+{
+    static size_t heap_usage(std::unordered_set<T, Hash, Equal, Allocator> const& v)
+    {
+        return v.size() * detail::hash_node_size<T>() + v.bucket_count() * sizeof(void*) +
+            type_proxy_range<std::unordered_set<T, Hash, Equal, Allocator>>::elements_heap_usage(v);
+    }
+};
 
 template<class T, class Hash, class Equal, class Allocator>
 class option_value<std::unordered_set<T, Hash, Equal, Allocator>>
@@ -53,7 +63,13 @@ public:
 template<class T, class Hash, class Equal, class Allocator>
 struct type_proxy<std::unordered_multiset<T, Hash, Equal, Allocator>>
     : type_proxy_range<std::unordered_multiset<T, Hash, Equal, Allocator>>
-{};
+{
+    static size_t heap_usage(std::unordered_multiset<T, Hash, Equal, Allocator> const& v)
+    {
+        return v.size() * detail::hash_node_size<T>() + v.bucket_count() * sizeof(void*) +
+            type_proxy_range<std::unordered_multiset<T, Hash, Equal, Allocator>>::elements_heap_usage(v);
+    }
+};
 
 template<class T, class Hash, class Equal, class Allocator>
 class option_value<std::unordered_multiset<T, Hash, Equal, Allocator>>
@@ -19,13 +19,26 @@
 #include <boost/test/unit_test.hpp>
 
 #include <boost/program_options/options_description.hpp>
+#include <boost/program_options/parsers.hpp>
 
 #define RACONFIG_VERSION_STRING "version test"
 #include <raconfig/raconfig.hpp>
 #include <raconfig/raconfig_set.hpp>
 #include <raconfig/raconfig_unordered_set.hpp>
+#include <raconfig/raconfig_sighup.hpp>
+#include <raconfig/raconfig_mapped_list.hpp>
+#include <raconfig/raconfig_tunable.hpp>
+#include <raconfig/raconfig_notifier.hpp>
+#include <raconfig/raconfig_regex.hpp>
+#include <raconfig/raconfig_enum.hpp>
+#include <raconfig/raconfig_admin.hpp>
 
+#include <chrono>
 #include <fstream>
+#include <thread>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 namespace option
 {
@@ -88,6 +101,21 @@ struct actions: raconfig::default_actions
     {
         res.append("# config end\n");
     }
+
+    void show_memory_begin() override
+    {
+        res = "# memory begin\n";
+    }
+
+    void show_memory(const char* name, size_t bytes) override
+    {
+        res.append(" ").append(name).append(": ").append(bytes > 0 ? "used" : "none").append("\n");
+    }
+
+    void show_memory_end() override
+    {
+        res.append("# memory end\n");
+    }
 };
 
 std::string actions::res;
@@ -322,8 +350,391 @@ BOOST_AUTO_TEST_CASE(test_unordered_multiset)
     BOOST_CHECK_EQUAL(cfg.get<unordered_multiset>().count(7), 2);
 }
 
+BOOST_AUTO_TEST_CASE(test_memory_usage)
+{
+    std::vector<std::string> args(1001);
+    for (size_t i = 1; i < args.size(); ++i)
+        args[i] = "--set-item=" + std::to_string(2 * i + 1);
+    std::vector<const char*> argv;
+    for (auto const& arg: args)
+        argv.push_back(arg.c_str());
+    auto& cfg = config::instance();
+    cfg.parse_cmd_line(static_cast<int>(argv.size()), argv.data());
+    auto usage = cfg.memory_usage();
+    BOOST_REQUIRE_EQUAL(usage.size(), 9);
+    BOOST_CHECK_EQUAL(usage[4].first, "set");
+    // staging vector and set nodes
+    BOOST_CHECK_GE(usage[4].second, 1000 * sizeof(int) + 1000 * (4 * sizeof(void*) + sizeof(int)));
+    BOOST_CHECK_LT(usage[5].second, 1000);
+}
+
+BOOST_AUTO_TEST_CASE(test_access_counts)
+{
+    auto& cfg = config::instance();
+    auto const before = cfg.access_counts();
+    auto read = [&cfg]() {
+        for (int i = 0; i < 1000; ++i)
+            cfg.get<set>();
+    };
+    read();
+    std::thread thread{read};
+    thread.join();
+    auto const after = cfg.access_counts();
+#ifdef RACONFIG_TRACE_ACCESS
+    BOOST_REQUIRE_EQUAL(after.size(), 9);
+    BOOST_CHECK_EQUAL(after[4].first, "set");
+    // sampled counts are off by less than a period per thread
+    long long const period = RACONFIG_DETAIL_ACCESS_PERIOD;
+    long long const reads = after[4].second - before[4].second;
+    BOOST_CHECK_GT(reads, 2000 - 2 * period);
+    BOOST_CHECK_LT(reads, 2000 + 2 * period);
+    BOOST_CHECK_EQUAL(after[5].second, before[5].second);
+#else
+    BOOST_CHECK(after.empty());
+#endif
+}
+
 BOOST_AUTO_TEST_SUITE_END() // containers_test_suite
 
+BOOST_AUTO_TEST_SUITE(lazy_test_suite)
+
+static unsigned checks = 0;
+
+bool count_check(std::set<int> const& v)
+{
+    ++checks;
+    return v.count(0) == 0;
+}
+
+RACONFIG_OPTION_LAZY_CHECKED(lazy_set, std::set<int>, RACONFIG_V({1, 2}),
+    &count_check, "lazy-item", RACONFIG_NO_NAME, "Lazy set")
+
+using config = raconfig::config<raconfig::default_actions, lazy_set>;
+
+BOOST_AUTO_TEST_CASE(test_lazy)
+{
+    const char *argv[] = {"",
+        "--lazy-item=3",
+        "--lazy-item=3",
+        "--lazy-item=4"
+    };
+    auto& cfg = config::instance();
+    checks = 0;
+    cfg.parse_cmd_line(4, argv);
+    BOOST_CHECK_EQUAL(checks, 0);
+    BOOST_CHECK((cfg.get<lazy_set>() == std::set<int>{3, 4}));
+    BOOST_CHECK((cfg.get<lazy_set>() == std::set<int>{3, 4}));
+    BOOST_CHECK_EQUAL(checks, 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_lazy_check_failed)
+{
+    const char *argv[] = {"",
+        "--lazy-item=0"
+    };
+    auto& cfg = config::instance();
+    cfg.parse_cmd_line(2, argv);
+    BOOST_CHECK_THROW(cfg.get<lazy_set>(), raconfig::config_error);
+    BOOST_CHECK_THROW(cfg.get<lazy_set>(), raconfig::config_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_eager)
+{
+    const char *argv[] = {"",
+        "--lazy-item=0"
+    };
+    auto& cfg = config::instance();
+    cfg.set_eager(true);
+    checks = 0;
+    BOOST_CHECK_THROW(cfg.parse_cmd_line(2, argv), raconfig::config_error);
+    BOOST_CHECK_EQUAL(checks, 1);
+    cfg.set_eager(false);
+}
+
+BOOST_AUTO_TEST_CASE(test_update_lazy_checked)
+{
+    auto& cfg = config::instance();
+    cfg.parse_cmd_line(0, nullptr);
+    checks = 0;
+    BOOST_CHECK_THROW(cfg.update({{"lazy-item", "0"}}), raconfig::config_error);
+    BOOST_CHECK_EQUAL(checks, 1);
+    BOOST_CHECK((cfg.get<lazy_set>() == std::set<int>{1, 2}));
+}
+
+BOOST_AUTO_TEST_SUITE_END() // lazy_test_suite
+
+BOOST_AUTO_TEST_SUITE(mapped_list_test_suite)
+
+RACONFIG_OPTION(hosts, raconfig::mapped_list, "",
+    "hosts", "hosts.file", "List of hosts")
+
+using config = raconfig::config<raconfig::default_actions, hosts>;
+
+struct list_file_fixture
+{
+    list_file_fixture()
+    {
+        std::ofstream file{"test.list"};
+        file << "host1\n"
+                "\n"
+                "host2\r\n"
+                "host3";
+    }
+
+    ~list_file_fixture()
+    {
+        std::remove("test.list");
+    }
+};
+
+BOOST_FIXTURE_TEST_CASE(test_mapped_list, list_file_fixture)
+{
+    const char *argv[] = {"",
+        "--hosts=test.list"
+    };
+    auto& cfg = config::instance();
+    cfg.parse_cmd_line(2, argv);
+    auto& list = cfg.get<hosts>();
+    BOOST_CHECK_EQUAL(list.path(), "test.list");
+    BOOST_REQUIRE_EQUAL(list.size(), 3);
+    BOOST_CHECK(list[0] == "host1");
+    BOOST_CHECK(list[1] == "host2");
+    BOOST_CHECK(list[2] == "host3");
+}
+
+BOOST_FIXTURE_TEST_CASE(test_mapped_list_reload, list_file_fixture)
+{
+    const char *argv[] = {"",
+        "--hosts=test.list"
+    };
+    auto& cfg = config::instance();
+    cfg.parse_cmd_line(2, argv);
+    auto const list = &cfg.get<hosts>();
+    // the same file is neither reparsed nor remapped
+    BOOST_CHECK(!cfg.reload());
+    cfg.parse_cmd_line(2, argv);
+    BOOST_CHECK_EQUAL(&cfg.get<hosts>(), list);
+
+    {
+        std::ofstream file{"test.list.new"};
+        file << "host4\n";
+    }
+    std::rename("test.list.new", "test.list");
+    BOOST_CHECK(cfg.reload());
+    BOOST_REQUIRE_EQUAL(cfg.get<hosts>().size(), 1);
+    BOOST_CHECK(cfg.get<hosts>()[0] == "host4");
+}
+
+BOOST_AUTO_TEST_CASE(test_mapped_list_default)
+{
+    const char *argv[] = {""};
+    auto& cfg = config::instance();
+    cfg.parse_cmd_line(1, argv);
+    BOOST_CHECK(cfg.get<hosts>().empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_mapped_list_no_file)
+{
+    const char *argv[] = {"",
+        "--hosts=abcdefghijklmnopqrstuvwxyz"
+    };
+    BOOST_CHECK_THROW(config::instance().parse_cmd_line(2, argv), raconfig::config_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END() // mapped_list_test_suite
+
+BOOST_AUTO_TEST_SUITE(regex_test_suite)
+
+RACONFIG_OPTION(pattern, raconfig::regex, "^[a-z]+$",
+    "pattern", "filter.pattern", "Host name pattern")
+
+using config = raconfig::config<raconfig::default_actions, pattern>;
+
+BOOST_AUTO_TEST_CASE(test_regex_unparsed)
+{
+    // the default pattern is used before any parse
+    auto const& re = raconfig::config<actions, pattern>::instance().get<pattern>();
+    BOOST_CHECK(re.valid());
+    BOOST_CHECK(re.search("localhost"));
+    BOOST_CHECK(!re.match("host1"));
+    BOOST_CHECK(!std::regex_search("1", re.get()));
+
+    raconfig::regex const invalid{"[a-"};
+    BOOST_CHECK(!invalid.valid());
+    BOOST_CHECK(!invalid.search("[a-"));
+    BOOST_CHECK(!raconfig::regex{}.match(""));
+}
+
+BOOST_AUTO_TEST_CASE(test_regex)
+{
+    const char *argv[] = {"",
+        "--pattern=^host[0-9]+$"
+    };
+    auto& cfg = config::instance();
+    cfg.parse_cmd_line(1, argv);
+    BOOST_CHECK(cfg.get<pattern>().match("localhost"));
+    cfg.parse_cmd_line(2, argv);
+    auto& re = cfg.get<pattern>();
+    BOOST_CHECK_EQUAL(re.pattern(), "^host[0-9]+$");
+    BOOST_CHECK(re.match("host42"));
+    BOOST_CHECK(!re.match("localhost"));
+    BOOST_CHECK(std::regex_search("host1", re.get()));
+}
+
+BOOST_AUTO_TEST_CASE(test_regex_invalid)
+{
+    const char *argv[] = {"",
+        "--pattern=[a-"
+    };
+    auto& cfg = config::instance();
+    try {
+        cfg.parse_cmd_line(2, argv);
+        BOOST_ERROR("config_error expected");
+    } catch (raconfig::config_error const& e) {
+        BOOST_CHECK_EQUAL(e.what(), "the argument ('[a-') check for option 'pattern' failed");
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END() // regex_test_suite
+
+BOOST_AUTO_TEST_SUITE(enum_test_suite)
+
+RACONFIG_ENUM(level, debug, info, warning, error)
+
+RACONFIG_OPTION(log_level, level, level::info,
+    "log-level", "log.level", "Log level")
+
+RACONFIG_OPTION(trace_levels, std::vector<level>, {},
+    "trace-level", "log.trace", "Traced levels")
+
+using config = raconfig::config<actions, log_level, trace_levels>;
+
+BOOST_AUTO_TEST_CASE(test_enum)
+{
+    const char *argv[] = {"",
+        "--log-level=WaRnInG"
+    };
+    auto& cfg = config::instance();
+    cfg.parse_cmd_line(2, argv);
+    BOOST_CHECK(cfg.get<log_level>() == level::warning);
+    BOOST_CHECK_EQUAL(raconfig::detail::to_string(level::error), "error");
+
+    const char *show[] = {"",
+        "--log-level=debug",
+        "--show-config"
+    };
+    cfg.parse_cmd_line(3, show);
+    BOOST_CHECK_EQUAL(actions::res, "# config begin\noptions:\n log_level: debug\n trace_levels:\n# config end\n");
+
+    const char *help[] = {"",
+        "--help"
+    };
+    cfg.parse_cmd_line(2, help);
+    BOOST_CHECK(actions::res.find("--log-level debug|info|warning|error") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(test_enum_invalid)
+{
+    const char *argv[] = {"",
+        "--log-level=warn"
+    };
+    try {
+        config::instance().parse_cmd_line(2, argv);
+        BOOST_ERROR("config_error expected");
+    } catch (raconfig::config_error const& e) {
+        BOOST_CHECK_EQUAL(e.what(), "the argument ('warn') for option '--log-level' is invalid");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_enum_list)
+{
+    const char *argv[] = {"",
+        "--trace-level=error",
+        "--trace-level=DEBUG"
+    };
+    auto& cfg = config::instance();
+    cfg.parse_cmd_line(3, argv);
+    BOOST_CHECK(cfg.get<trace_levels>() == (std::vector<level>{level::error, level::debug}));
+}
+
+RACONFIG_ENUM(mode, fast, Fast)
+
+BOOST_AUTO_TEST_CASE(test_enum_duplicate)
+{
+    try {
+        raconfig::detail::parse_enum<mode>("fast");
+        BOOST_ERROR("config_error expected");
+    } catch (raconfig::config_error const& e) {
+        BOOST_CHECK_EQUAL(e.what(), "enumerators 'fast' and 'Fast' differ only in case");
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END() // enum_test_suite
+
+BOOST_AUTO_TEST_SUITE(tunable_test_suite)
+
+struct triple
+{
+    uint64_t a, b, c;
+};
+
+std::istream& operator >> (std::istream& is, triple& t)
+{
+    is >> t.a;
+    t.b = t.c = t.a;
+    return is;
+}
+
+std::ostream& operator << (std::ostream& os, triple const& t)
+{
+    return os << t.a << ':' << t.b << ':' << t.c;
+}
+
+RACONFIG_OPTION_CHECKED(rate, raconfig::tunable<unsigned>, 100,
+    [](unsigned v) { return v > 0; },
+    "rate", "rate", "Rate limit")
+RACONFIG_OPTION(wide, raconfig::tunable<triple>, RACONFIG_V(triple{1, 1, 1}),
+    "wide", "wide", "Triple of equal numbers")
+
+using config = raconfig::config<raconfig::default_actions, rate, wide>;
+
+BOOST_AUTO_TEST_CASE(test_tunable)
+{
+    const char *argv[] = {"",
+        "--rate=10",
+        "--wide=5"
+    };
+    auto& cfg = config::instance();
+    cfg.parse_cmd_line(3, argv);
+    BOOST_CHECK_EQUAL(cfg.get<rate>(), 10);
+    BOOST_CHECK_EQUAL(cfg.get<wide>().load().c, 5);
+    cfg.set<rate>(20);
+    BOOST_CHECK_EQUAL(cfg.get<rate>(), 20);
+    BOOST_CHECK_THROW(cfg.set<rate>(0), raconfig::config_error);
+    BOOST_CHECK_EQUAL(cfg.get<rate>(), 20);
+}
+
+BOOST_AUTO_TEST_CASE(test_tunable_concurrent)
+{
+    auto& cfg = config::instance();
+    std::atomic<bool> stop{false};
+    std::atomic<bool> torn{false};
+    std::thread reader{[&]() {
+        while (!stop) {
+            triple const t = cfg.get<wide>();
+            if (t.a != t.b || t.b != t.c)
+                torn = true;
+        }
+    }};
+    for (uint64_t i = 0; i < 100000; ++i)
+        cfg.set<wide>(triple{i, i, i});
+    stop = true;
+    reader.join();
+    BOOST_CHECK(!torn);
+}
+
+BOOST_AUTO_TEST_SUITE_END() // tunable_test_suite
+
 BOOST_AUTO_TEST_SUITE(actions_test_suite)
 
 BOOST_AUTO_TEST_CASE(test_help)
@@ -367,6 +778,23 @@ BOOST_AUTO_TEST_CASE(test_show_config)
         "# config end\n");
 }
 
+BOOST_AUTO_TEST_CASE(test_show_memory)
+{
+    const char *argv[] = {"",
+        "--show-memory"
+    };
+    actions::res.clear();
+    config::instance().parse_cmd_line(2, argv);
+    BOOST_CHECK_EQUAL(actions::res, "# memory begin\n"
+        " text: used\n"
+        " number: used\n"
+        " flag: used\n"
+        " cmd_only_int: used\n"
+        " cfg_only_int: used\n"
+        " power2: used\n"
+        "# memory end\n");
+}
+
 BOOST_AUTO_TEST_SUITE_END() // action_test_suite
 
 BOOST_AUTO_TEST_CASE(test_defaults)
@@ -447,6 +875,203 @@ BOOST_FIXTURE_TEST_CASE(test_cmd_line_cfg_file, cfg_file_fixture)
     BOOST_CHECK((cfg.get<option::power2>() == std::vector<unsigned>{64, 128, 256}));
 }
 
+BOOST_AUTO_TEST_CASE(test_cfg_buffer)
+{
+    std::string const buffer = "cfg_only_int=12345\n"
+                               "[common]\n"
+                               "number=8080\n"
+                               "[power2]\n"
+                               "item=64\n";
+    const char *argv[] = {"",
+        "--number=1" // override buffer
+    };
+    auto& cfg = config::instance();
+    cfg.parse_buffer(buffer.data(), buffer.size(), 2, argv);
+    BOOST_CHECK_EQUAL(cfg.get<option::text>(), "default text");
+    BOOST_CHECK_EQUAL(cfg.get<option::number>(), 1);
+    BOOST_CHECK_EQUAL(cfg.get<option::cfg_only_int>(), 12345);
+    BOOST_CHECK((cfg.get<option::power2>() == std::vector<unsigned>{64}));
+    BOOST_CHECK_THROW(cfg.reload(), raconfig::config_error);
+
+    const char *bad[] = {"",
+        "--config=test.ini" // only one configuration source is allowed
+    };
+    BOOST_CHECK_THROW(cfg.parse_buffer(buffer.data(), buffer.size(), 2, bad), raconfig::config_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_cfg_fd)
+{
+    int fds[2];
+    BOOST_REQUIRE_EQUAL(pipe(fds), 0);
+    std::string const buffer = "[common]\n"
+                               "text=text from pipe\n"
+                               "flag=1\n";
+    BOOST_REQUIRE_EQUAL(write(fds[1], buffer.data(), buffer.size()), ssize_t(buffer.size()));
+    close(fds[1]);
+    auto& cfg = config::instance();
+    cfg.parse_fd(fds[0]);
+    close(fds[0]);
+    BOOST_CHECK_EQUAL(cfg.get<option::text>(), "text from pipe");
+    BOOST_CHECK_EQUAL(cfg.get<option::flag>(), true);
+    BOOST_CHECK_EQUAL(cfg.get<option::number>(), 80);
+}
+
+BOOST_AUTO_TEST_CASE(test_environment)
+{
+    using config = raconfig::config<raconfig::default_actions, option::text, option::number, option::cfg_only_int>;
+    setenv("RACONFIG_TEST_COMMON_TEXT", "text from env", 1);
+    setenv("RACONFIG_TEST_COMMON_NUMBER", "8080", 1);
+    setenv("RACONFIG_TEST_CFG_ONLY_INT", "7", 1);
+    setenv("OTHER_COMMON_NUMBER", "1", 1);
+    std::string const buffer = "cfg_only_int=1\n"
+                               "[common]\n"
+                               "text=text from file\n"
+                               "number=1\n";
+    const char *argv[] = {"",
+        "--text=text from cmd" // override env
+    };
+    auto& cfg = config::instance();
+    cfg.set_env_prefix("RACONFIG_TEST");
+    cfg.parse_buffer(buffer.data(), buffer.size(), 2, argv);
+    BOOST_CHECK_EQUAL(cfg.get<option::text>(), "text from cmd");
+    BOOST_CHECK_EQUAL(cfg.get<option::number>(), 8080);
+    BOOST_CHECK_EQUAL(cfg.get<option::cfg_only_int>(), 7);
+    unsetenv("RACONFIG_TEST_COMMON_NUMBER");
+    cfg.parse_buffer(buffer.data(), buffer.size(), 2, argv);
+    BOOST_CHECK_EQUAL(cfg.get<option::number>(), 1);
+
+    cfg.parse_cmd_line(0, nullptr);
+    BOOST_CHECK_EQUAL(cfg.get<option::text>(), "text from env");
+    BOOST_CHECK(!cfg.reload());
+    setenv("RACONFIG_TEST_CFG_ONLY_INT", "8", 1);
+    BOOST_CHECK(cfg.reload());
+    BOOST_CHECK_EQUAL(cfg.get<option::cfg_only_int>(), 8);
+
+    unsetenv("RACONFIG_TEST_COMMON_TEXT");
+    unsetenv("RACONFIG_TEST_CFG_ONLY_INT");
+    unsetenv("OTHER_COMMON_NUMBER");
+    cfg.set_env_prefix(nullptr);
+}
+
+RACONFIG_OPTION(common_number, int, 0,
+    "common-number", "common_number", "Clashes with common.number in environment")
+
+BOOST_AUTO_TEST_CASE(test_env_name_collision)
+{
+    using config = raconfig::config<raconfig::default_actions, option::number, common_number>;
+    try {
+        config::instance().set_env_prefix("RACONFIG_TEST");
+        BOOST_ERROR("config_error expected");
+    } catch (raconfig::config_error const& e) {
+        BOOST_CHECK_EQUAL(e.what(), "options 'common.number' and 'common_number' have the same "
+                                    "environment variable RACONFIG_TEST_COMMON_NUMBER");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_get_several)
+{
+    const char *argv[] = {"",
+        "--text=several",
+        "--number=8080"
+    };
+    auto& cfg = config::instance();
+    cfg.parse_cmd_line(3, argv);
+    auto const opts = cfg.get<option::text, option::number, option::flag>();
+    BOOST_CHECK_EQUAL(std::get<0>(opts), "several");
+    BOOST_CHECK_EQUAL(std::get<1>(opts), 8080);
+    BOOST_CHECK_EQUAL(std::get<2>(opts), false);
+    BOOST_CHECK_EQUAL(&std::get<0>(opts), &cfg.get<option::text>());
+}
+
+BOOST_AUTO_TEST_CASE(test_cmd_line_repeated_list)
+{
+    std::vector<std::string> args;
+    for (unsigned i = 0; i < 10000; ++i)
+        args.push_back("--power2=" + std::to_string(1u << (i % 32)));
+    args.push_back("--power2");
+    args.push_back("2");
+    args.push_back("-f");
+    args.push_back("1");
+    std::vector<const char*> argv{""};
+    for (auto const& arg: args)
+        argv.push_back(arg.c_str());
+    auto& cfg = config::instance();
+    cfg.parse_cmd_line(static_cast<int>(argv.size()), argv.data());
+    auto const& power2 = cfg.get<option::power2>();
+    BOOST_REQUIRE_EQUAL(power2.size(), 10001);
+    BOOST_CHECK_EQUAL(power2[33], 2);
+    BOOST_CHECK_EQUAL(power2.back(), 2);
+    BOOST_CHECK_EQUAL(cfg.get<option::flag>(), true);
+
+    const char *bad[] = {"",
+        "--power2=4",
+        "--power2=four"
+    };
+    try {
+        cfg.parse_cmd_line(3, bad);
+        BOOST_ERROR("config_error expected");
+    } catch (raconfig::config_error const& e) {
+        BOOST_CHECK_EQUAL(e.what(), "the argument ('four') for option '--power2' is invalid");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_cmd_line_numbers)
+{
+    auto& cfg = config::instance();
+    const char *argv[] = {"",
+        "--number=08080",
+        "--cmd-only-int=-2147483648"
+    };
+    cfg.parse_cmd_line(3, argv);
+    BOOST_CHECK_EQUAL(cfg.get<option::number>(), 8080);
+    BOOST_CHECK_EQUAL(cfg.get<option::cmd_only_int>(), std::numeric_limits<int>::min());
+
+    // same as boost::lexical_cast
+    const char *wrapped[] = {"",
+        "--number=-1"
+    };
+    cfg.parse_cmd_line(2, wrapped);
+    BOOST_CHECK_EQUAL(cfg.get<option::number>(), 65535);
+
+    for (const char *arg: {"--number=65536", "--number=1x", "--cmd-only-int=2147483648"}) {
+        const char *bad[] = {"", arg};
+        try {
+            cfg.parse_cmd_line(2, bad);
+            BOOST_ERROR("config_error expected");
+        } catch (raconfig::config_error const& e) {
+            std::string const name{arg, std::strchr(arg, '=')};
+            BOOST_CHECK_EQUAL(e.what(), "the argument ('" + std::string{std::strchr(arg, '=') + 1} +
+                              "') for option '" + name + "' is invalid");
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_cmd_line_empty_value)
+{
+    namespace po = boost::program_options;
+    po::options_description desc;
+    desc.add_options()
+        ("text", po::value<std::string>(), "")
+        ("number", po::value<unsigned short>(), "")
+        ("power2", po::value<std::vector<unsigned>>(), "");
+    for (const char *arg: {"--text=", "--number=", "--power2="}) {
+        const char *argv[] = {"", arg};
+        std::string expected;
+        try {
+            po::parse_command_line(2, argv, desc);
+        } catch (po::error const& e) {
+            expected = e.what();
+        }
+        BOOST_REQUIRE(!expected.empty());
+        try {
+            config::instance().parse_cmd_line(2, argv);
+            BOOST_ERROR("config_error expected");
+        } catch (raconfig::config_error const& e) {
+            BOOST_CHECK_EQUAL(e.what(), expected);
+        }
+    }
+}
+
 BOOST_AUTO_TEST_CASE(test_cfg_only_option_in_cmd_line)
 {
     const char *argv[] = {"",
@@ -499,6 +1124,213 @@ BOOST_FIXTURE_TEST_CASE(test_option_check_failed, option_check_failed_fixture)
     BOOST_CHECK_THROW(config::instance().parse_file("test.ini"), raconfig::config_error);
 }
 
+BOOST_FIXTURE_TEST_CASE(test_unchanged_options_shared, cfg_file_fixture)
+{
+    const char *argv1[] = {"",
+        "--config=test.ini",
+        "--number=1"
+    };
+    const char *argv2[] = {"",
+        "--config=test.ini",
+        "--number=2"
+    };
+    const char *argv3[] = {"",
+        "--config=test.ini",
+        "--number=2",
+        "--power2=2"
+    };
+    auto& cfg = config::instance();
+    cfg.parse_cmd_line(3, argv1);
+    auto const text = &cfg.get<option::text>();
+    auto const power2 = &cfg.get<option::power2>();
+    auto const cmd_only_int = &cfg.get<option::cmd_only_int>();
+    cfg.parse_cmd_line(3, argv2);
+    BOOST_CHECK_EQUAL(cfg.get<option::number>(), 2);
+    BOOST_CHECK_EQUAL(&cfg.get<option::text>(), text);
+    BOOST_CHECK_EQUAL(&cfg.get<option::power2>(), power2);
+    BOOST_CHECK_EQUAL(&cfg.get<option::cmd_only_int>(), cmd_only_int);
+    cfg.parse_cmd_line(4, argv3);
+    BOOST_CHECK_EQUAL(&cfg.get<option::text>(), text);
+    BOOST_CHECK((cfg.get<option::power2>() == std::vector<unsigned>{2}));
+}
+
+BOOST_AUTO_TEST_CASE(test_reference_lifetime)
+{
+    const char *argv[] = {"",
+        "--text=first text which does not fit into the small string buffer"
+    };
+    auto& cfg = config::instance();
+    cfg.quiescent();
+    cfg.parse_cmd_line(2, argv);
+    auto const& text = cfg.get<option::text>();
+    const char *next[] = {"",
+        "--text=second"
+    };
+    cfg.parse_cmd_line(2, next);
+    cfg.get<option::number>();
+    // the reference is kept until the thread is quiescent
+    BOOST_CHECK_EQUAL(text, "first text which does not fit into the small string buffer");
+    BOOST_CHECK_EQUAL(cfg.get<option::text>(), "second");
+    cfg.quiescent();
+    cfg.parse_cmd_line(2, argv);
+    BOOST_CHECK_EQUAL(cfg.get<option::text>(), "first text which does not fit into the small string buffer");
+}
+
+// counts values alive in all snapshots
+struct counted
+{
+    counted(int value = 0): value{value} { ++alive; }
+    counted(counted const& other): value{other.value} { ++alive; }
+    counted& operator = (counted const&) = default;
+    ~counted() { --alive; }
+
+    int value;
+    static int alive;
+};
+
+int counted::alive = 0;
+
+std::istream& operator >> (std::istream& is, counted& v)
+{
+    return is >> v.value;
+}
+
+std::ostream& operator << (std::ostream& os, counted const& v)
+{
+    return os << v.value;
+}
+
+RACONFIG_OPTION_EASY(counted_value, counted, 0, "Counted value")
+
+BOOST_AUTO_TEST_CASE(test_retired_bounded)
+{
+    using config = raconfig::config<raconfig::default_actions, counted_value>;
+    auto& cfg = config::instance();
+    cfg.parse_cmd_line(0, nullptr);
+    int const alive = counted::alive;
+    // the thread never calls quiescent(), replaced snapshots are not kept
+    for (int i = 0; i < 1000; ++i) {
+        std::string const arg = "--counted_value=" + std::to_string(i + 1);
+        const char *argv[] = {"", arg.c_str()};
+        cfg.parse_cmd_line(2, argv);
+        BOOST_REQUIRE_EQUAL(cfg.get<counted_value>().value, i + 1);
+    }
+    BOOST_CHECK_LE(counted::alive, alive + 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_numa_replicas)
+{
+    using config = raconfig::config<raconfig::default_actions,
+        option::text, option::number, option::power2>;
+    auto& cfg = config::instance();
+    cfg.set_numa_replicas(true);
+    const char *argv1[] = {"",
+        "--text=replicated",
+        "--power2=4"
+    };
+    const char *argv2[] = {"",
+        "--text=replicated",
+        "--power2=8"
+    };
+    cfg.parse_cmd_line(3, argv1);
+    auto const text = &cfg.get<option::text>();
+    BOOST_CHECK_EQUAL(*text, "replicated");
+    BOOST_CHECK((cfg.get<option::power2>() == std::vector<unsigned>{4}));
+    cfg.parse_cmd_line(3, argv2);
+    // unchanged option keeps its replica
+    BOOST_CHECK_EQUAL(&cfg.get<option::text>(), text);
+    BOOST_CHECK((cfg.get<option::power2>() == std::vector<unsigned>{8}));
+
+    std::thread reader{[&cfg]() {
+        BOOST_CHECK_EQUAL(cfg.get<option::text>(), "replicated");
+        BOOST_CHECK_EQUAL(cfg.get<option::number>(), 80);
+    }};
+    reader.join();
+}
+
+BOOST_AUTO_TEST_CASE(test_derived)
+{
+    static int computed = 0;
+    using config = raconfig::config<raconfig::default_actions,
+        option::text, option::number, option::flag>;
+    config::derived<std::string(option::text, option::number)> const url{
+        [](std::string const& host, unsigned short port) {
+            ++computed;
+            return host + ":" + std::to_string(port);
+        }};
+    BOOST_CHECK_EQUAL(url.get(), "default text:80");
+    BOOST_CHECK_EQUAL(computed, 1);
+
+    auto& cfg = config::instance();
+    const char *argv1[] = {"",
+        "--text=localhost",
+        "--number=8080"
+    };
+    cfg.parse_cmd_line(3, argv1);
+    BOOST_CHECK_EQUAL(url.get(), "localhost:8080");
+    BOOST_CHECK_EQUAL(computed, 2);
+
+    const char *argv2[] = {"",
+        "--text=localhost",
+        "--number=8080",
+        "--flag=1"
+    };
+    auto const value = &url.get();
+    cfg.parse_cmd_line(4, argv2);
+    BOOST_CHECK_EQUAL(&url.get(), value);
+    BOOST_CHECK_EQUAL(computed, 2);
+
+    config::derived<int(option::number)> const failing{[](unsigned short port) -> int {
+        if (port == 1)
+            throw std::invalid_argument{"bad port"};
+        return port;
+    }};
+    const char *bad[] = {"",
+        "--number=1"
+    };
+    BOOST_CHECK_THROW(cfg.parse_cmd_line(2, bad), raconfig::config_error);
+    // the previous configuration is kept
+    BOOST_CHECK_EQUAL(failing.get(), 8080);
+    BOOST_CHECK_EQUAL(url.get(), "localhost:8080");
+}
+
+BOOST_AUTO_TEST_CASE(test_overlay)
+{
+    const char *argv[] = {"",
+        "--text=base",
+        "--number=10",
+        "--power2=4"
+    };
+    auto& cfg = config::instance();
+    cfg.parse_cmd_line(4, argv);
+
+    const char *overrides[] = {"",
+        "--number=20",
+        "-f1"
+    };
+    config::overlay const tenant{cfg, 3, overrides};
+    BOOST_CHECK_EQUAL(tenant.overrides(), 2);
+    BOOST_CHECK_EQUAL(tenant.get<option::number>(), 20);
+    BOOST_CHECK_EQUAL(tenant.get<option::flag>(), true);
+    BOOST_CHECK_EQUAL(&tenant.get<option::text>(), &cfg.get<option::text>());
+    BOOST_CHECK_EQUAL(&tenant.get<option::power2>(), &cfg.get<option::power2>());
+
+    const char *more[] = {"",
+        "--number=30"
+    };
+    config::overlay const nested{tenant, 2, more};
+    BOOST_CHECK_EQUAL(nested.overrides(), 2);
+    BOOST_CHECK_EQUAL(nested.get<option::number>(), 30);
+    BOOST_CHECK_EQUAL(nested.get<option::flag>(), true);
+    BOOST_CHECK_EQUAL(tenant.get<option::number>(), 20);
+    BOOST_CHECK_EQUAL(cfg.get<option::number>(), 10);
+
+    const char *bad[] = {"",
+        "--power2=3"
+    };
+    BOOST_CHECK_THROW((config::overlay{cfg, 2, bad}), raconfig::config_error);
+}
+
 BOOST_AUTO_TEST_CASE(test_callbacks)
 {
     static unsigned short number = 0;
@@ -518,3 +1350,313 @@ BOOST_AUTO_TEST_CASE(test_callbacks)
     BOOST_CHECK_EQUAL(number, 42);
     BOOST_CHECK(flag);
 }
+
+BOOST_AUTO_TEST_CASE(test_change_notifier)
+{
+    using config = raconfig::config<raconfig::default_actions, option::number>;
+    auto readable = [](int fd) {
+        pollfd pfd{fd, POLLIN, 0};
+        return poll(&pfd, 1, 0) == 1;
+    };
+    auto& cfg = config::instance();
+    raconfig::change_notifier<config> notifier;
+    BOOST_CHECK(!readable(notifier.fd()));
+
+    const char *argv[] = {"",
+        "--number=42"
+    };
+    auto const before = cfg.generation();
+    std::thread{[&argv]() { config::instance().parse_cmd_line(2, argv); }}.join();
+    BOOST_CHECK(readable(notifier.fd()));
+    BOOST_CHECK_EQUAL(notifier.consume(), before + 1);
+    BOOST_CHECK(!readable(notifier.fd()));
+    BOOST_CHECK_EQUAL(cfg.get<option::number>(), 42);
+
+    const char *bad[] = {"",
+        "--number=abc"
+    };
+    BOOST_CHECK_THROW(cfg.parse_cmd_line(2, bad), raconfig::config_error);
+    BOOST_CHECK(!readable(notifier.fd()));
+    BOOST_CHECK_EQUAL(cfg.generation(), before + 1);
+}
+
+#if __cplusplus >= 202002L
+struct detached_task
+{
+    struct promise_type
+    {
+        detached_task get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+using awaited_config = raconfig::config<raconfig::default_actions, option::number, option::cmd_only_int>;
+
+detached_task wait_number(std::vector<std::coroutine_handle<>>& executor, unsigned short& seen)
+{
+    auto& cfg = awaited_config::instance();
+    co_await cfg.changed<option::number>([&executor](std::coroutine_handle<> h) { executor.push_back(h); });
+    seen = cfg.get<option::number>();
+}
+
+BOOST_AUTO_TEST_CASE(test_changed_awaitable)
+{
+    auto& cfg = awaited_config::instance();
+    const char *argv[] = {"",
+        "--number=1"
+    };
+    cfg.parse_cmd_line(2, argv);
+    std::vector<std::coroutine_handle<>> executor;
+    unsigned short seen = 0;
+    wait_number(executor, seen);
+    const char *other[] = {"",
+        "--number=1",
+        "--cmd-only-int=2"
+    };
+    cfg.parse_cmd_line(3, other);
+    BOOST_CHECK(executor.empty());
+    const char *changed[] = {"",
+        "--number=42"
+    };
+    cfg.parse_cmd_line(2, changed);
+    BOOST_REQUIRE_EQUAL(executor.size(), 1u);
+    BOOST_CHECK_EQUAL(seen, 0);
+    executor.front().resume();
+    BOOST_CHECK_EQUAL(seen, 42);
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(test_update)
+{
+    static int updates = 0;
+    static int common_updates = 0;
+    static int power2_updates = 0;
+    using config = raconfig::config<raconfig::default_actions, option::text, option::number, option::power2>;
+    config::callback const cb{[](){ ++updates; }};
+    config::callback const common_cb{"common", [](){ ++common_updates; }};
+    config::callback const power2_cb{"power2", [](){ ++power2_updates; }};
+    auto& cfg = config::instance();
+    auto const before = cfg.generation();
+    BOOST_CHECK_EQUAL(cfg.update({{"text", "updated"}, {"common.number", "42"},
+                                  {"power2", "2"}, {"power2.item", "4"}}), before + 1);
+    BOOST_CHECK_EQUAL(updates, 1);
+    BOOST_CHECK_EQUAL(common_updates, 1);
+    BOOST_CHECK_EQUAL(power2_updates, 1);
+    BOOST_CHECK_EQUAL(cfg.get<option::text>(), "updated");
+    BOOST_CHECK_EQUAL(cfg.get<option::number>(), 42);
+    BOOST_CHECK(cfg.get<option::power2>() == (std::vector<unsigned>{2, 4}));
+
+    // nothing is committed if any value is invalid
+    BOOST_CHECK_THROW(cfg.update({{"number", "43"}, {"power2", "3"}}), raconfig::config_error);
+    BOOST_CHECK_THROW(cfg.update({{"unknown", "1"}}), raconfig::config_error);
+    BOOST_CHECK_EQUAL(cfg.generation(), before + 1);
+    BOOST_CHECK_EQUAL(updates, 1);
+    BOOST_CHECK_EQUAL(cfg.get<option::number>(), 42);
+
+    // only callbacks of updated sections are invoked
+    cfg.update({{"common.number", "42"}});
+    BOOST_CHECK_EQUAL(updates, 2);
+    BOOST_CHECK_EQUAL(common_updates, 2);
+    BOOST_CHECK_EQUAL(power2_updates, 1);
+
+    std::string value;
+    BOOST_REQUIRE(cfg.value("common.text", value));
+    BOOST_CHECK_EQUAL(value, "updated");
+    BOOST_CHECK(!cfg.value("unknown", value));
+    auto const values = cfg.values();
+    BOOST_REQUIRE_EQUAL(values.size(), 3);
+    BOOST_CHECK_EQUAL(values[2].first, "power2");
+    BOOST_CHECK_EQUAL(values[2].second, "{2, 4}");
+
+    // reload overrides updates
+    const char *argv[] = {""};
+    cfg.parse_cmd_line(1, argv);
+    BOOST_CHECK_EQUAL(cfg.get<option::number>(), 80);
+}
+
+BOOST_AUTO_TEST_CASE(test_admin_server)
+{
+    using config = raconfig::config<raconfig::default_actions, option::text, option::number>;
+    auto request = [](std::string const& s) {
+        int const fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strcpy(addr.sun_path, "test.sock");
+        BOOST_REQUIRE(connect(fd, reinterpret_cast<sockaddr const*>(&addr), sizeof addr) == 0);
+        BOOST_REQUIRE(send(fd, s.data(), s.size(), 0) == static_cast<ssize_t>(s.size()));
+        shutdown(fd, SHUT_WR);
+        std::string res;
+        char buf[256];
+        for (ssize_t n; (n = recv(fd, buf, sizeof buf, 0)) > 0;)
+            res.append(buf, n);
+        close(fd);
+        return res;
+    };
+    auto& cfg = config::instance();
+    raconfig::admin_server<config> server{"test.sock"};
+    // an idle client doesn't block others
+    int const idle = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strcpy(addr.sun_path, "test.sock");
+    BOOST_REQUIRE(connect(idle, reinterpret_cast<sockaddr const*>(&addr), sizeof addr) == 0);
+    BOOST_REQUIRE(send(idle, "get", 3, 0) == 3);
+    auto const gen = std::to_string(cfg.generation() + 1);
+    BOOST_CHECK_EQUAL(request("text=admin\nnumber=7\n\nget number\n"), "ok " + gen + "\nok 7\n");
+    BOOST_CHECK_EQUAL(cfg.get<option::text>(), "admin");
+    BOOST_CHECK_EQUAL(request("number=x\n\nnumber\n"),
+                      "error the argument ('x') for option '--number' is invalid\n"
+                      "error expected name=value, get name or dump\n");
+    BOOST_CHECK_EQUAL(request("get common.text\ndump\nnumber=8\n\n"),
+                      "ok admin\ntext = admin\nnumber = 7\nok\nok " + std::to_string(cfg.generation() + 1) + "\n");
+    BOOST_CHECK_EQUAL(cfg.get<option::number>(), 8);
+    // a batch cut off by the end of the connection is discarded
+    auto const committed = cfg.generation();
+    BOOST_CHECK_EQUAL(request("text=cut\nnumber=84"), "");
+    BOOST_CHECK_EQUAL(request("text=cut\nnumber=84\n"), "");
+    BOOST_CHECK_EQUAL(cfg.generation(), committed);
+    BOOST_CHECK_EQUAL(cfg.get<option::text>(), "admin");
+    BOOST_CHECK_EQUAL(cfg.get<option::number>(), 8);
+    BOOST_CHECK_EQUAL(request("number=9\n" + std::string(70000, 'x')), "error line is too long\n");
+    BOOST_CHECK_EQUAL(cfg.get<option::number>(), 8);
+    close(idle);
+
+    std::ofstream{"test.ini"} << "not a socket\n";
+    BOOST_CHECK_THROW(raconfig::admin_server<config>{"test.ini"}, raconfig::config_error);
+    std::ifstream file{"test.ini"};
+    BOOST_CHECK(file.is_open());
+}
+
+struct reload_file_fixture: file_fixture<reload_file_fixture>
+{
+    void write(std::ostream& file)
+    {
+        file << "[common]\n"
+                "number=1\n";
+    }
+};
+
+BOOST_FIXTURE_TEST_CASE(test_reload_unchanged_skipped, reload_file_fixture)
+{
+    static int reloads = 0;
+    using config = raconfig::config<raconfig::default_actions, option::number, option::text>;
+    config::callback const cb{[](){ ++reloads; }};
+    const char *argv[] = {"",
+        "--config=test.ini",
+        "--text=reload"
+    };
+    auto& cfg = config::instance();
+    cfg.parse_cmd_line(3, argv);
+    BOOST_CHECK_EQUAL(reloads, 1);
+    BOOST_CHECK(!cfg.reload());
+    BOOST_CHECK_EQUAL(reloads, 1);
+    {
+        std::ofstream file{"test.ini"};
+        file << "[common]\n"
+                "number=2\n";
+    }
+    BOOST_CHECK(cfg.reload());
+    BOOST_CHECK_EQUAL(reloads, 2);
+    BOOST_CHECK_EQUAL(cfg.get<option::number>(), 2);
+    BOOST_CHECK(!cfg.reload());
+    BOOST_CHECK_EQUAL(reloads, 2);
+}
+
+struct section_file_fixture: file_fixture<section_file_fixture>
+{
+    void write(std::ostream& file)
+    {
+        file << "[common]\n"
+                "number=99\n" // not in the section
+                "[power2]\n"
+                "item=4\n"
+                "item=8\n";
+    }
+};
+
+BOOST_FIXTURE_TEST_CASE(test_section_reload, section_file_fixture)
+{
+    static int reloads = 0;
+    static int section_reloads = 0;
+    using config = raconfig::config<raconfig::default_actions, option::number, option::power2>;
+    config::callback const cb{[](){ ++reloads; }};
+    config::callback const section_cb{"power2", [](){ ++section_reloads; }};
+    std::string const buffer = "[common]\n"
+                               "number=1\n"
+                               "[power2]\n"
+                               "item=2\n";
+    auto& cfg = config::instance();
+    cfg.parse_buffer(buffer.data(), buffer.size());
+    BOOST_CHECK_EQUAL(reloads, 1);
+    BOOST_CHECK_EQUAL(section_reloads, 1);
+    auto const number = &cfg.get<option::number>();
+
+    cfg.parse_section("power2", "test.ini");
+    BOOST_CHECK_EQUAL(reloads, 1);
+    BOOST_CHECK_EQUAL(section_reloads, 2);
+    BOOST_CHECK_EQUAL(cfg.get<option::number>(), 1);
+    BOOST_CHECK_EQUAL(&cfg.get<option::number>(), number);
+    BOOST_CHECK((cfg.get<option::power2>() == std::vector<unsigned>{4, 8}));
+
+    // the section is detached from the main source, its callback isn't
+    // invoked by full parses
+    cfg.parse_buffer(buffer.data(), buffer.size());
+    BOOST_CHECK_EQUAL(reloads, 2);
+    BOOST_CHECK_EQUAL(section_reloads, 2);
+    BOOST_CHECK((cfg.get<option::power2>() == std::vector<unsigned>{4, 8}));
+    {
+        std::ofstream file{"test.ini"};
+        file << "[power2]\n"
+                "item=16\n";
+    }
+    cfg.reload_section("power2");
+    BOOST_CHECK_EQUAL(section_reloads, 3);
+    BOOST_CHECK((cfg.get<option::power2>() == std::vector<unsigned>{16}));
+    BOOST_CHECK_THROW(cfg.reload_section("common"), raconfig::config_error);
+
+    std::string const bad = "[power2]\n"
+                            "item=3\n";
+    BOOST_CHECK_THROW(cfg.parse_section_buffer("power2", bad.data(), bad.size()), raconfig::config_error);
+    BOOST_CHECK((cfg.get<option::power2>() == std::vector<unsigned>{16}));
+    cfg.parse_section_buffer("power2", "", 0);
+    BOOST_CHECK(cfg.get<option::power2>().empty());
+    BOOST_CHECK_THROW(cfg.reload_section("power2"), raconfig::config_error);
+}
+
+struct sighup_file_fixture: file_fixture<sighup_file_fixture>
+{
+    void write(std::ostream& file)
+    {
+        file << "[common]\n"
+                "number=1\n";
+    }
+};
+
+BOOST_FIXTURE_TEST_CASE(test_sighup_reload, sighup_file_fixture)
+{
+    static std::atomic<int> reloads{0};
+    using config = raconfig::config<raconfig::default_actions, option::number>;
+    config::callback const cb{[](){ ++reloads; }};
+    const char *argv[] = {"",
+        "--config=test.ini"
+    };
+    auto& cfg = config::instance();
+    cfg.parse_cmd_line(2, argv);
+    BOOST_CHECK_EQUAL(cfg.get<option::number>(), 1);
+
+    raconfig::sighup_reloader<config> reloader;
+    {
+        std::ofstream file{"test.ini"};
+        file << "[common]\n"
+                "number=2\n";
+    }
+    int const before = reloads;
+    kill(getpid(), SIGHUP);
+    auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds{10};
+    while (reloads == before && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    BOOST_CHECK_EQUAL(cfg.get<option::number>(), 2);
+}